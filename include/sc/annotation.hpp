@@ -17,8 +17,11 @@
 #pragma once
 
 #include <sc/generator.hpp>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/IR/Module.h>
 #include <sc/transformer.hpp>
+#include <cstdint>
+#include <string>
 #include <string_view>
 
 namespace sc
@@ -32,15 +35,21 @@ namespace sc
     template< typename Value >
     using annotated = std::pair< llvm_value< Value >, annotation >;
 
+    //
+    // Annotation parts are interned in a global pool, an annotation is a
+    // short sequence of part ids. Comparisons and namespace checks work on
+    // the ids, spellings are looked up only when requested.
+    //
     struct annotation
     {
-        using parts_t        = std::vector< std::string >;
+        using part_id        = uint32_t;
+        using parts_t        = llvm::SmallVector< part_id, 4 >;
         using iterator       = parts_t::iterator;
         using const_iterator = parts_t::const_iterator;
 
-        template< typename... parts_t > constexpr explicit annotation( parts_t... parts )
+        template< typename... parts_t > explicit annotation( parts_t... parts )
         {
-            ( _parts.push_back( parts ), ... );
+            ( _parts.push_back( intern( parts ) ), ... );
         }
 
         explicit annotation( llvm::StringRef anno )
@@ -48,7 +57,7 @@ namespace sc
             size_t oldoff = 0, off = 0;
             do {
                     off = anno.find( '.', oldoff );
-                    _parts.emplace_back( anno.substr( oldoff, off - oldoff ) );
+                    _parts.push_back( intern( anno.substr( oldoff, off - oldoff ) ) );
                     oldoff = off + 1;
             } while ( off != std::string::npos );
         }
@@ -65,7 +74,11 @@ namespace sc
 
         [[nodiscard]] bool in_namespace( const annotation &ns ) const;
 
-        bool operator==( const annotation & ) const = default;
+        bool operator==( const annotation &other ) const { return _parts == other._parts; }
+
+        // id of the part in the global pool, thread safe
+        static part_id intern( llvm::StringRef part );
+        static const std::string &spelling( part_id id );
 
         parts_t _parts;
 
@@ -0,0 +1,158 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <sc/annotation.hpp>
+#include <sc/generator.hpp>
+#include <sc/recursive_generator.hpp>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/ValueHandle.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sc
+{
+    //
+    // Index of llvm.global.annotations of a module. Annotations are stored in
+    // a prefix trie over their interned parts with separate buckets for functions,
+    // global variables and all global values. The index is built on the
+    // first query and rebuilt whenever the initializer of the annotation
+    // array is replaced or an annotation_writer modifies any module. Other
+    // edits of the annotation strings require an explicit 'invalidate'.
+    // Namespace queries visit only the matching subtree.
+    //
+    // Generators returned by queries borrow the index and must not outlive
+    // it or be interleaved with a rebuild.
+    //
+    struct annotation_index
+    {
+        explicit annotation_index( llvm::Module &m ) : module( m ) {}
+
+        // values annotated by the exact annotation
+        template< typename Value >
+        sc::generator< annotated< Value > > find( annotation ann );
+
+        // values annotated by an annotation strictly inside the namespace
+        template< typename Value >
+        sc::recursive_generator< annotated< Value > > in_namespace( annotation ns );
+
+        template< typename Value >
+        sc::recursive_generator< annotated< Value > > all() { return in_namespace< Value >( annotation() ); }
+
+        [[nodiscard]] std::size_t size();
+
+        void invalidate() { root.reset(); }
+
+        // announces a change of annotations, all indices rebuild on their
+        // next query; called by annotation_writer
+        static void changed();
+
+    private:
+        struct entry
+        {
+            llvm::GlobalValue *value;
+            annotation ann;
+        };
+
+        struct node
+        {
+            std::map< annotation::part_id, std::unique_ptr< node > > children;
+
+            // indices to entries annotated exactly by the path to the node,
+            // 'values' holds all of them and is filtered for other kinds
+            std::vector< std::size_t > functions, variables, values;
+
+            template< typename Value >
+            const std::vector< std::size_t > &bucket() const
+            {
+                if constexpr ( std::is_same_v< Value, llvm::Function > )
+                    return functions;
+                else if constexpr ( std::is_same_v< Value, llvm::GlobalVariable > )
+                    return variables;
+                else
+                    return values;
+            }
+        };
+
+        // rebuilds the trie if the annotations changed since the last query
+        void update();
+        void insert( llvm::GlobalValue *val, annotation ann );
+
+        const node *lookup( const annotation &ann );
+
+        template< typename Value >
+        sc::recursive_generator< annotated< Value > > walk( const node *n );
+
+        template< typename Value >
+        bool holds( std::size_t idx ) const { return llvm::isa< Value >( entries[ idx ].value ); }
+
+        template< typename Value >
+        annotated< Value > get( std::size_t idx ) const
+        {
+            const auto &e = entries[ idx ];
+            return { llvm::cast< Value >( e.value ), e.ann };
+        }
+
+        llvm::Module &module;
+        // tracks deletion of the constant, so a reused address is not
+        // mistaken for the indexed initializer
+        llvm::WeakVH initializer;
+        std::uint64_t generation = 0;
+
+        std::unique_ptr< node > root;
+        std::vector< entry > entries;
+    };
+
+    template< typename Value >
+    sc::generator< annotated< Value > > annotation_index::find( annotation ann )
+    {
+        if ( auto n = lookup( ann ) ) {
+            for ( auto idx : n->template bucket< Value >() )
+                if ( holds< Value >( idx ) )
+                    co_yield get< Value >( idx );
+        }
+    }
+
+    template< typename Value >
+    sc::recursive_generator< annotated< Value > > annotation_index::walk( const node *n )
+    {
+        for ( auto idx : n->template bucket< Value >() )
+            if ( holds< Value >( idx ) )
+                co_yield get< Value >( idx );
+        for ( const auto &[ part, child ] : n->children )
+            co_yield walk< Value >( child.get() );
+    }
+
+    template< typename Value >
+    sc::recursive_generator< annotated< Value > > annotation_index::in_namespace( annotation ns )
+    {
+        // entries of the namespace node itself are not inside the namespace,
+        // buckets along the way may be empty
+        if ( auto n = lookup( ns ) ) {
+            for ( const auto &[ part, child ] : n->children )
+                co_yield walk< Value >( child.get() );
+        }
+    }
+
+} // namespace sc
@@ -0,0 +1,66 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <sc/annotation.hpp>
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Module.h>
+
+#include <vector>
+
+namespace sc
+{
+    //
+    // Collects annotations of many values and emits them into
+    // llvm.global.annotations in a single step. Annotation strings are
+    // emitted once per distinct spelling (reusing strings of entries already
+    // present in the module) and existing entries are kept.
+    //
+    struct annotation_writer
+    {
+        explicit annotation_writer( llvm::Module &m ) : module( m ) {}
+
+        void add( llvm::GlobalValue *val, const annotation &ann,
+                  llvm::StringRef file = "", unsigned line = 0 );
+
+        // merges pending annotations into the module, the writer can be
+        // reused afterwards
+        void finalize();
+
+        [[nodiscard]] std::size_t pending() const { return entries.size(); }
+
+    private:
+        struct entry
+        {
+            llvm::GlobalValue *val;
+            std::string ann;
+            std::string file;
+            unsigned line;
+        };
+
+        // pointer to the first character of a deduplicated string global
+        llvm::Constant *string( llvm::StringRef str );
+        void seed( llvm::ConstantArray *existing );
+
+        llvm::Module &module;
+        llvm::StringMap< llvm::Constant * > strings;
+        std::vector< entry > entries;
+    };
+
+} // namespace sc
@@ -16,11 +16,18 @@
 
 #pragma once
 
+#include <llvm/Analysis/InstructionSimplify.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Operator.h>
 #include <sc/context.hpp>
 #include <sc/types.hpp>
 #include <sc/bimap.hpp>
+#include <sc/numbering.hpp>
+#include <sc/runtime.hpp>
+#include <sc/ssa.hpp>
 
+#include <functional>
+#include <memory>
 #include <span>
 #include <vector>
 #include <optional>
@@ -39,12 +46,20 @@ namespace sc
     using predicate = llvm::CmpInst::Predicate;
     using binop = llvm::Instruction::BinaryOps;
 
+    enum class reduction { add, mul, and_, or_, xor_, smax, smin, umax, umin, fmax, fmin };
+
     struct phi_edge
     {
         value val;
         basicblock from;
     };
 
+    struct switch_case
+    {
+        llvm::ConstantInt *val;
+        basicblock dst;
+    };
+
     struct stack_builder;
 
     namespace build
@@ -95,6 +110,32 @@ namespace sc
         struct ptrtoint : cast { using cast::cast; };
         struct inttoptr : cast { using cast::cast; };
 
+        struct gep
+        {
+            type ty;
+            value ptr;
+            values indices;
+        };
+
+        struct field
+        {
+            type ty;
+            value ptr;
+            std::vector< unsigned > path;
+        };
+
+        struct extractvalue
+        {
+            value agg;
+            std::vector< unsigned > path;
+        };
+
+        struct insertvalue
+        {
+            value agg, val;
+            std::vector< unsigned > path;
+        };
+
         struct condbr
         {
             value cond;
@@ -106,6 +147,19 @@ namespace sc
             basicblock dst;
         };
 
+        struct switch_
+        {
+            value cond;
+            basicblock otherwise;
+            std::vector< switch_case > cases;
+        };
+
+        struct indirectbr
+        {
+            value addr;
+            std::vector< basicblock > dsts;
+        };
+
         struct call
         {
             function_callee fn;
@@ -117,6 +171,38 @@ namespace sc
             std::optional< value > val;
         };
 
+        struct insertelement { value vec, elt, idx; };
+        struct extractelement { value vec, idx; };
+
+        struct shufflevector
+        {
+            value lhs, rhs;
+            std::vector< int > mask;
+        };
+
+        struct splat
+        {
+            unsigned n;
+            value val;
+        };
+
+        struct masked_load
+        {
+            type ty;
+            value ptr, mask;
+            unsigned align;
+            value passthru = nullptr; // undef when not given
+        };
+
+        struct masked_store
+        {
+            value val, ptr, mask;
+            unsigned align;
+        };
+
+        template< reduction r >
+        struct reduce { value vec; };
+
     } // namespace build
 
     namespace action
@@ -145,6 +231,7 @@ namespace sc
         struct store
         {
             std::optional< value > val, dst;
+            std::string to_var = "";
         };
 
         template< binop op >
@@ -221,6 +308,36 @@ namespace sc
 
         using phi = build::phi;
 
+        // inbounds getelementptr
+        struct gep
+        {
+            type ty;
+            std::optional< value > ptr;
+            values indices;
+        };
+
+        // address of a (nested) field of an aggregate pointed to by 'ptr',
+        // a constant gep popped from the stack is merged into the access
+        // and erased when nothing else refers to it
+        struct field
+        {
+            type ty;
+            std::optional< value > ptr;
+            std::vector< unsigned > path;
+        };
+
+        struct extractvalue
+        {
+            std::optional< value > agg;
+            std::vector< unsigned > path;
+        };
+
+        struct insertvalue
+        {
+            std::optional< value > agg, val;
+            std::vector< unsigned > path;
+        };
+
         struct condbr
         {
             explicit condbr( value c ) : cond( c ) {}
@@ -237,6 +354,29 @@ namespace sc
             basicblock dst;
         };
 
+        struct switch_
+        {
+            std::optional< value > cond;
+            basicblock otherwise;
+            std::vector< switch_case > cases;
+        };
+
+        //
+        // Multiway branch that picks its lowering by case density. Dense
+        // tables become an indirect branch through a constant table of
+        // block addresses indexed by the condition, sparse ones a switch.
+        //
+        struct dispatch
+        {
+            std::optional< value > cond;
+            basicblock otherwise;
+            std::vector< switch_case > cases;
+
+            double density = 0.4;     // minimal ratio of cases to the covered range
+            unsigned min_cases = 4;   // smaller tables are left to switch
+            unsigned max_range = 4096;
+        };
+
         struct call
         {
             call( function_callee callee, const std::span< value > &as )
@@ -254,19 +394,115 @@ namespace sc
             std::vector< std::optional< value > > args;
         };
 
+        //
+        // Call of a hook obtained from sc::runtime, arguments are coerced by
+        // the plan cached in the runtime function.
+        //
+        struct runtime_call
+        {
+            const runtime_function &fn;
+            llvm::SmallVector< std::optional< value >, 4 > args;
+        };
+
         struct ret
         {
             std::optional< value > val;
         };
 
+        struct insertelement
+        {
+            std::optional< value > vec, elt, idx;
+        };
+
+        struct extractelement
+        {
+            std::optional< value > vec, idx;
+        };
+
+        struct shufflevector
+        {
+            std::optional< value > lhs, rhs;
+            std::vector< int > mask;
+        };
+
+        struct splat
+        {
+            unsigned n;
+            std::optional< value > val;
+        };
+
+        struct masked_load
+        {
+            type ty;
+            std::optional< value > ptr, mask;
+            unsigned align = 1;
+            value passthru = nullptr;
+        };
+
+        struct masked_store
+        {
+            std::optional< value > val, ptr, mask;
+            unsigned align = 1;
+        };
+
+        template< reduction r >
+        struct reduce
+        {
+            std::optional< value > vec;
+        };
+
+        using reduce_add  = reduce< reduction::add >;
+        using reduce_mul  = reduce< reduction::mul >;
+        using reduce_and  = reduce< reduction::and_ >;
+        using reduce_or   = reduce< reduction::or_ >;
+        using reduce_xor  = reduce< reduction::xor_ >;
+        using reduce_smax = reduce< reduction::smax >;
+        using reduce_smin = reduce< reduction::smin >;
+        using reduce_umax = reduce< reduction::umax >;
+        using reduce_umin = reduce< reduction::umin >;
+        using reduce_fmax = reduce< reduction::fmax >;
+        using reduce_fmin = reduce< reduction::fmin >;
+
+        //
+        // Counted loop 'for ( iv = start; iv < count; iv += step ) body'.
+        //
+        // With unroll or vector width above one, a main loop runs the body
+        // 'unroll' times per iteration on 'width' consecutive steps each,
+        // followed by a scalar remainder loop. The body receives the
+        // induction value and the number of steps it has to cover:
+        //
+        //   stack_builder body( stack_builder &&, value iv, unsigned width )
+        //
+        template< typename body_t >
+        struct loop
+        {
+            loop( std::optional< value > n, uint64_t s, body_t b, unsigned u = 1, unsigned w = 1 )
+                : count( n ), step( s ), body( std::move( b ) ), unroll( u ), width( w )
+            {}
+
+            std::optional< value > count;
+            uint64_t step;
+            body_t body;
+            unsigned unroll, width;
+            value start = nullptr; // zero when not set
+        };
+
+        template< typename body_t >
+        loop( std::optional< value >, uint64_t, body_t, unsigned = 1, unsigned = 1 ) -> loop< body_t >;
+
+        // invokes 'void callback( stack_builder* )', the callback is kept
+        // by its type to be inlined without allocation
+        template< typename callback >
         struct inspect
         {
-            using callback = std::function< void( stack_builder* ) >;
-            explicit inspect( callback &&c ) : call( std::move( c ) ) {}
+            explicit inspect( callback c ) : call( std::move( c ) ) {}
 
             callback call;
         };
 
+        template< typename callback >
+        inspect( callback ) -> inspect< callback >;
+
         struct last {}; // last produced value
 
         struct create_block { std::string name = ""; };
@@ -286,6 +522,16 @@ namespace sc
 
         struct keep_stack {};
 
+        // simplify and value-number pure instructions at emission
+        struct fold {};
+
+        // track named variables as ssa values instead of allocas
+        struct ssa_mode {};
+
+        // all predecessors of the block are known (empty name = current block)
+        struct seal_block { std::string name = ""; };
+        struct seal_all {};
+
         struct push { value val; };
 
         struct pop { unsigned n = 1; };
@@ -307,6 +553,46 @@ namespace sc
             return llvm::cast< inst >( val );
         }
 
+        void enable_folding()
+        {
+            if ( !numbering )
+                numbering = std::make_unique< value_numbering >();
+        }
+
+        [[nodiscard]] bool folding() const { return numbering != nullptr; }
+        [[nodiscard]] const fold_stats &stats() const { return folded; }
+
+        // Emits a pure instruction computing 'e' unless it simplifies to an
+        // existing value or an equal instruction is available in the block.
+        template< typename simplify_t, typename create_t >
+        value fold( const expression &e, simplify_t &&simplify, create_t &&create )
+        {
+            auto bb = GetInsertBlock();
+            auto constant = []( value v ) { return !v || llvm::isa< llvm::Constant >( v ); };
+            if ( !bb || ( constant( e.lhs ) && constant( e.rhs ) ) )
+                return create(); // left to the constant folder
+
+            if ( auto m = bb->getModule() ) {
+                if ( auto v = simplify( llvm::SimplifyQuery( m->getDataLayout() ) ) ) {
+                    ++folded.simplified;
+                    return v;
+                }
+            }
+
+            if ( auto v = numbering->lookup( bb, e ) ) {
+                auto point = GetInsertPoint();
+                if ( point == bb->end() || as_inst( v )->comesBefore( &*point ) ) {
+                    ++folded.reused;
+                    return v;
+                }
+            }
+
+            value v = create();
+            if ( llvm::isa< inst >( v ) )
+                numbering->insert( bb, e, v );
+            return v;
+        }
+
         auto alloc( type ty ) { return CreateAlloca( ty ); }
         auto alloc( type ty, const std::string &name )
         {
@@ -318,34 +604,113 @@ namespace sc
         auto store( value val, value ptr ) { return CreateStore( val, ptr ); }
 
         template< binop op >
-        auto bin( value l, value r ) { return CreateBinOp( op, l, r ); }
+        value bin( value l, value r )
+        {
+            if ( !folding() )
+                return CreateBinOp( op, l, r );
+
+            // commutative operations are numbered regardless of operand order
+            auto [ a, b ] = llvm::Instruction::isCommutative( op ) && std::less<>()( r, l )
+                          ? std::pair( r, l ) : std::pair( l, r );
+            return fold( expression{ static_cast< unsigned >( op ), 0, l->getType(), a, b },
+                [&] ( const auto &q ) { return llvm::SimplifyBinOp( op, l, r, q ); },
+                [&] { return CreateBinOp( op, l, r ); } );
+        }
 
         template< predicate pred >
-        auto cmp( value l, value r )
+        value cmp( value l, value r )
         {
-            return llvm::CmpInst::isFPPredicate( pred )
-               ? CreateFCmp( pred, l, r )
-               : CreateICmp( pred, l, r );
+            auto create = [&] {
+                return llvm::CmpInst::isFPPredicate( pred )
+                   ? CreateFCmp( pred, l, r )
+                   : CreateICmp( pred, l, r );
+            };
+
+            if ( !folding() )
+                return create();
+
+            auto opcode = llvm::CmpInst::isFPPredicate( pred ) ? inst::FCmp : inst::ICmp;
+            return fold( expression{ opcode, pred, nullptr, l, r },
+                [&] ( const auto &q ) { return llvm::SimplifyCmpInst( pred, l, r, q ); },
+                create );
         }
 
-        auto bitcast( value v, type to ) { return CreateBitCast( v, to ); }
+        value cast( llvm::Instruction::CastOps op, value v, type to )
+        {
+            if ( !folding() )
+                return CreateCast( op, v, to );
+
+            return fold( expression{ op, 0, to, v },
+                [&] ( const auto &q ) { return llvm::SimplifyCastInst( op, v, to, q ); },
+                [&] { return CreateCast( op, v, to ); } );
+        }
+
+        auto bitcast( value v, type to ) { return cast( inst::BitCast, v, to ); }
 
         auto zfit( value v, type to )
         {
             if ( v->getType() == to )
                 return v;
-            return CreateZExtOrTrunc( v, to );
+            auto from = v->getType()->getScalarSizeInBits();
+            return cast( from < to->getScalarSizeInBits() ? inst::ZExt : inst::Trunc, v, to );
         }
 
         auto fptoui( value v, type to )
         {
             if ( v->getType() == to )
                 return v;
-            return CreateFPToUI( v, to );
+            return cast( inst::FPToUI, v, to );
+        }
+
+        auto ptrtoint( value v, type to ) { return cast( inst::PtrToInt, v, to ); }
+        auto inttoptr( value v, type to ) { return cast( inst::IntToPtr, v, to ); }
+
+        auto gep( type ty, value ptr, llvm::ArrayRef< value > indices )
+        {
+            return CreateInBoundsGEP( ty, ptr, indices );
+        }
+
+        //
+        // Field addresses are constant inbounds geps. Chains of constant
+        // geps are merged into one, so the result stays a single access
+        // path for alias analysis. Pointers that do not point to the
+        // aggregate (e.g. i8*) are offset by the field offset in bytes.
+        //
+        value field( type ty, value ptr, const std::vector< unsigned > &path )
+        {
+            auto pty = llvm::cast< llvm::PointerType >( ptr->getType() );
+            if ( pty->getPointerElementType() != ty ) {
+                auto &dl  = GetInsertBlock()->getModule()->getDataLayout();
+                auto off  = offset( ty, path, dl );
+                auto addr = CreateInBoundsGEP( getInt8Ty(), ptr, getInt64( off ) );
+                auto fty  = field_type( ty, path );
+                return CreatePointerCast( addr, fty->getPointerTo( pty->getAddressSpace() ) );
+            }
+
+            values indices;
+            auto inner = llvm::dyn_cast< llvm::GEPOperator >( ptr );
+            if ( inner && inner->isInBounds() && inner->hasAllConstantIndices() ) {
+                indices.assign( inner->idx_begin(), inner->idx_end() );
+                ty  = inner->getSourceElementType();
+                ptr = inner->getPointerOperand();
+            } else {
+                indices.push_back( getInt32( 0 ) );
+            }
+
+            for ( auto idx : path )
+                indices.push_back( getInt32( idx ) );
+            return gep( ty, ptr, indices );
+        }
+
+        auto extractvalue( value agg, llvm::ArrayRef< unsigned > path )
+        {
+            return CreateExtractValue( agg, path );
         }
 
-        auto ptrtoint( value v, type to ) { return CreatePtrToInt( v, to ); }
-        auto inttoptr( value v, type to ) { return CreateIntToPtr( v, to ); }
+        auto insertvalue( value agg, value val, llvm::ArrayRef< unsigned > path )
+        {
+            return CreateInsertValue( agg, val, path );
+        }
 
         auto phi( const std::vector< phi_edge > &edges )
         {
@@ -363,12 +728,68 @@ namespace sc
 
         auto br( basicblock dst ) { return CreateBr(dst); }
 
+        auto switch_( value c, basicblock otherwise, const std::vector< switch_case > &cases )
+        {
+            auto sw = CreateSwitch( c, otherwise, unsigned( cases.size() ) );
+            for ( auto [ val, dst ] : cases )
+                sw->addCase( val, dst );
+            return sw;
+        }
+
+        auto indirectbr( value addr, const std::vector< basicblock > &dsts )
+        {
+            auto br = CreateIndirectBr( addr, unsigned( dsts.size() ) );
+            for ( auto dst : dsts )
+                br->addDestination( dst );
+            return br;
+        }
+
         auto call( function fn, const values &args ) { return CreateCall( fn, args ); }
         auto call( function_callee fn, const values &args ) { return CreateCall( fn, args ); }
 
         auto ret( value val ) { return CreateRet( val ); }
         auto retvoid() { return CreateRetVoid(); }
 
+        auto insertelement( value vec, value elt, value idx )
+        {
+            return CreateInsertElement( vec, elt, idx );
+        }
+
+        auto extractelement( value vec, value idx ) { return CreateExtractElement( vec, idx ); }
+
+        auto shufflevector( value l, value r, llvm::ArrayRef< int > mask )
+        {
+            return CreateShuffleVector( l, r, mask );
+        }
+
+        auto splat( unsigned n, value val ) { return CreateVectorSplat( n, val ); }
+
+        auto masked_load( type ty, value ptr, unsigned align, value mask, value passthru )
+        {
+            return CreateMaskedLoad( ty, ptr, llvm::Align( align ), mask, passthru );
+        }
+
+        auto masked_store( value val, value ptr, unsigned align, value mask )
+        {
+            return CreateMaskedStore( val, ptr, llvm::Align( align ), mask );
+        }
+
+        template< reduction r >
+        auto reduce( value vec )
+        {
+            if constexpr ( r == reduction::add )  return CreateAddReduce( vec );
+            if constexpr ( r == reduction::mul )  return CreateMulReduce( vec );
+            if constexpr ( r == reduction::and_ ) return CreateAndReduce( vec );
+            if constexpr ( r == reduction::or_ )  return CreateOrReduce( vec );
+            if constexpr ( r == reduction::xor_ ) return CreateXorReduce( vec );
+            if constexpr ( r == reduction::smax ) return CreateIntMaxReduce( vec, true );
+            if constexpr ( r == reduction::smin ) return CreateIntMinReduce( vec, true );
+            if constexpr ( r == reduction::umax ) return CreateIntMaxReduce( vec, false );
+            if constexpr ( r == reduction::umin ) return CreateIntMinReduce( vec, false );
+            if constexpr ( r == reduction::fmax ) return CreateFPMaxReduce( vec );
+            if constexpr ( r == reduction::fmin ) return CreateFPMinReduce( vec );
+        }
+
         auto create( build::alloc a )
         {
             if ( a.name.has_value() )
@@ -392,6 +813,12 @@ namespace sc
 
         auto create( build::phi p ) { return phi( p.edges ); }
 
+        auto create( const build::gep &g ) { return gep( g.ty, g.ptr, g.indices ); }
+        auto create( const build::field &f ) { return field( f.ty, f.ptr, f.path ); }
+
+        auto create( const build::extractvalue &e ) { return extractvalue( e.agg, e.path ); }
+        auto create( const build::insertvalue &i ) { return insertvalue( i.agg, i.val, i.path ); }
+
         auto create( build::bitcast c )  { return bitcast( c.val, c.to ); }
         auto create( build::zfit z )     { return zfit( z.val, z.to ); }
         auto create( build::fptoui z )   { return fptoui( z.val, z.to ); }
@@ -401,12 +828,42 @@ namespace sc
         auto create( build::condbr b ) { return condbr( b.cond, b.thenbb, b.elsebb ); }
         auto create( build::branch b ) { return br( b.dst ); }
 
+        auto create( const build::switch_ &s ) { return switch_( s.cond, s.otherwise, s.cases ); }
+        auto create( const build::indirectbr &b ) { return indirectbr( b.addr, b.dsts ); }
+
         auto create( build::call c ) { return call( c.fn, c.args ); }
 
         auto create( build::ret r )
         {
             return r.val.has_value() ? ret( r.val.value() ) : retvoid();
         }
+
+        auto create( build::insertelement i ) { return insertelement( i.vec, i.elt, i.idx ); }
+        auto create( build::extractelement e ) { return extractelement( e.vec, e.idx ); }
+
+        auto create( const build::shufflevector &s )
+        {
+            return shufflevector( s.lhs, s.rhs, s.mask );
+        }
+
+        auto create( build::splat s ) { return splat( s.n, s.val ); }
+
+        auto create( build::masked_load l )
+        {
+            return masked_load( l.ty, l.ptr, l.align, l.mask, l.passthru );
+        }
+
+        auto create( build::masked_store s )
+        {
+            return masked_store( s.val, s.ptr, s.align, s.mask );
+        }
+
+        template< reduction r >
+        auto create( build::reduce< r > red ) { return reduce< r >( red.vec ); }
+
+    private:
+        std::unique_ptr< value_numbering > numbering;
+        fold_stats folded;
     };
 
     struct stack_builder
@@ -450,8 +907,20 @@ namespace sc
             return v.has_value() ? v.value() : (keep_stack ? back() : pop());
         }
 
+        bool referenced( value v ) const
+        {
+            auto var = [ v ] ( const auto &named ) { return named.second == v; };
+            return std::find( stack.begin(), stack.end(), v ) != stack.end()
+                || std::any_of( vars.begin(), vars.end(), var );
+        }
+
         auto apply( action::alloc a ) &&
         {
+            if ( ssa && a.name.has_value() ) {
+                ssa->declare( a.name.value(), a.ty );
+                return std::move( *this );
+            }
+
             value var = builder->create( a );
 
             if ( a.name.has_value() ) {
@@ -464,7 +933,14 @@ namespace sc
 
         auto apply( action::load l ) &&
         {
-            push( builder->create( build::load{ l.ty, vars.at( l.from_var ) } ) );
+            if ( ssa && ssa->declared( l.from_var ) ) {
+                push( ssa->read( l.from_var, builder->GetInsertBlock() ) );
+                return std::move(*this);
+            }
+
+            value ptr = l.from_var.empty() ? popvalue( std::nullopt ) : vars.at( l.from_var );
+            type ty = l.ty ? l.ty : ptr->getType()->getPointerElementType();
+            push( builder->create( build::load{ ty, ptr } ) );
             return std::move(*this);
         }
 
@@ -477,7 +953,12 @@ namespace sc
         auto apply( action::store s ) &&
         {
             value v = popvalue( s.val );
-            value d = popvalue( s.dst );
+            if ( ssa && ssa->declared( s.to_var ) ) {
+                ssa->write( s.to_var, builder->GetInsertBlock(), v );
+                return std::move(*this);
+            }
+
+            value d = s.to_var.empty() ? popvalue( s.dst ) : vars.at( s.to_var );
             builder->create( build::store{ v, d } );
             return std::move(*this);
         }
@@ -522,6 +1003,43 @@ namespace sc
         auto apply( action::ptrtoint c ) && { return apply_cast< build::ptrtoint >( c ); }
         auto apply( action::inttoptr c ) && { return apply_cast< build::inttoptr >( c ); }
 
+        auto apply( action::gep g ) &&
+        {
+            value ptr = popvalue( g.ptr );
+            push( builder->create( build::gep{ g.ty, ptr, std::move( g.indices ) } ) );
+            return std::move(*this);
+        }
+
+        auto apply( action::field f ) &&
+        {
+            bool consumed = !f.ptr.has_value() && !keep_stack;
+            value ptr  = popvalue( f.ptr );
+            value addr = builder->create( build::field{ f.ty, ptr, std::move( f.path ) } );
+            push( addr );
+
+            // a constant gep taken from the stack and merged into the access
+            // is dead unless something else still refers to it
+            auto inner = llvm::dyn_cast< llvm::GetElementPtrInst >( ptr );
+            if ( consumed && inner && inner != addr && inner->use_empty() && !referenced( inner ) )
+                inner->eraseFromParent();
+            return std::move(*this);
+        }
+
+        auto apply( action::extractvalue e ) &&
+        {
+            value agg = popvalue( e.agg );
+            push( builder->create( build::extractvalue{ agg, std::move( e.path ) } ) );
+            return std::move(*this);
+        }
+
+        auto apply( action::insertvalue i ) &&
+        {
+            value agg = popvalue( i.agg );
+            value val = popvalue( i.val );
+            push( builder->create( build::insertvalue{ agg, val, std::move( i.path ) } ) );
+            return std::move(*this);
+        }
+
         auto apply( action::condbr br ) &&
         {
             value cond = popvalue( br.cond );
@@ -538,6 +1056,75 @@ namespace sc
             return std::move(*this);
         }
 
+        auto apply( action::switch_ s ) &&
+        {
+            value cond = popvalue( s.cond );
+            push( builder->create( build::switch_{ cond, s.otherwise, std::move( s.cases ) } ) );
+            return std::move(*this);
+        }
+
+        auto apply( action::dispatch d ) &&
+        {
+            value cond = popvalue( d.cond );
+
+            // case values are signed, so tables may span negative values
+            auto bits = cond->getType()->getIntegerBitWidth();
+            auto less = [] ( const auto &a, const auto &b ) { return a.val->getValue().slt( b.val->getValue() ); };
+            auto [ lo, hi ] = std::minmax_element( d.cases.begin(), d.cases.end(), less );
+
+            // distance of the extreme cases, exact for any pair of 64-bit values
+            auto span = [ lo = lo, hi = hi ] {
+                return uint64_t( hi->val->getSExtValue() ) - uint64_t( lo->val->getSExtValue() );
+            };
+
+            auto dense = [ & ] {
+                if ( d.cases.size() < d.min_cases || bits > 64 || span() >= d.max_range )
+                    return false;
+                return double( d.cases.size() ) >= d.density * double( span() + 1 );
+            };
+
+            if ( d.cases.empty() || !dense() ) {
+                push( builder->create( build::switch_{ cond, d.otherwise, std::move( d.cases ) } ) );
+                return std::move(*this);
+            }
+
+            auto min   = lo->val->getSExtValue();
+            auto range = span() + 1;
+
+            // table of targets indexed by 'cond - min', holes go to 'otherwise'
+            auto fn = builder->GetInsertBlock()->getParent();
+            auto otherwise = llvm::BlockAddress::get( fn, d.otherwise );
+            std::vector< llvm::Constant * > slots( range, otherwise );
+            std::vector< basicblock > dsts = { d.otherwise };
+            for ( auto [ val, dst ] : d.cases ) {
+                slots[ uint64_t( val->getSExtValue() ) - uint64_t( min ) ] = llvm::BlockAddress::get( fn, dst );
+                if ( std::find( dsts.begin(), dsts.end(), dst ) == dsts.end() )
+                    dsts.push_back( dst );
+            }
+
+            auto aty   = llvm::ArrayType::get( otherwise->getType(), range );
+            auto init  = llvm::ConstantArray::get( aty, slots );
+            auto table = new llvm::GlobalVariable( *fn->getParent(), aty, true,
+                llvm::GlobalValue::PrivateLinkage, init, "dispatch.table" );
+            table->setUnnamedAddr( llvm::GlobalValue::UnnamedAddr::Global );
+
+            auto lookup = make_block( fresh_label( "dispatch" ) );
+
+            auto ty  = cond->getType();
+            auto idx = builder->bin< binop::Sub >( cond, llvm::ConstantInt::getSigned( ty, min ) );
+            // 'range' is 2^bits for a table covering the whole type, 'span' always fits
+            auto in  = builder->cmp< predicate::ICMP_ULE >( idx, llvm::ConstantInt::get( ty, span() ) );
+            builder->condbr( in, lookup, d.otherwise );
+            seal( lookup );
+
+            enter( lookup );
+            value offset = builder->zfit( idx, i64() );
+            auto addr = builder->CreateInBoundsGEP( aty, table, { builder->getInt64( 0 ), offset } );
+            auto target = builder->load( otherwise->getType(), addr );
+            push( builder->create( build::indirectbr{ target, dsts } ) );
+            return std::move(*this);
+        }
+
         auto function_type_from_value( value v )
         {
             if ( v->getType()->isPointerTy() ) {
@@ -557,10 +1144,12 @@ namespace sc
         {
             values args;
 
+            auto fty = c.fn.getFunctionType();
+
             unsigned idx = 0;
             for ( auto arg : c.args ) {
                 auto a = popvalue( arg );
-                auto to = function_argument_type( c.fn, idx++ );
+                auto to = fty->getParamType( idx++ );
                 if ( to != a->getType() ) {
                     a = builder->create( build::bitcast( a, to ) );
                 }
@@ -572,6 +1161,71 @@ namespace sc
             return std::move(*this);
         }
 
+        auto apply( action::runtime_call c ) &&
+        {
+            llvm::SmallVector< value, 4 > args;
+            for ( auto arg : c.args )
+                args.push_back( popvalue( arg ) );
+
+            push( c.fn.call( *builder, args ) );
+            return std::move(*this);
+        }
+
+        auto apply( action::insertelement i ) &&
+        {
+            value vec = popvalue( i.vec );
+            value elt = popvalue( i.elt );
+            value idx = popvalue( i.idx );
+            push( builder->create( build::insertelement{ vec, elt, idx } ) );
+            return std::move(*this);
+        }
+
+        auto apply( action::extractelement e ) &&
+        {
+            value vec = popvalue( e.vec );
+            value idx = popvalue( e.idx );
+            push( builder->create( build::extractelement{ vec, idx } ) );
+            return std::move(*this);
+        }
+
+        auto apply( action::shufflevector s ) &&
+        {
+            value l = popvalue( s.lhs );
+            value r = popvalue( s.rhs );
+            push( builder->create( build::shufflevector{ l, r, std::move( s.mask ) } ) );
+            return std::move(*this);
+        }
+
+        auto apply( action::splat s ) &&
+        {
+            push( builder->create( build::splat{ s.n, popvalue( s.val ) } ) );
+            return std::move(*this);
+        }
+
+        auto apply( action::masked_load l ) &&
+        {
+            value ptr  = popvalue( l.ptr );
+            value mask = popvalue( l.mask );
+            push( builder->create( build::masked_load{ l.ty, ptr, mask, l.align, l.passthru } ) );
+            return std::move(*this);
+        }
+
+        auto apply( action::masked_store s ) &&
+        {
+            value val  = popvalue( s.val );
+            value ptr  = popvalue( s.ptr );
+            value mask = popvalue( s.mask );
+            builder->create( build::masked_store{ val, ptr, mask, s.align } );
+            return std::move(*this);
+        }
+
+        template< reduction r >
+        auto apply( action::reduce< r > red ) &&
+        {
+            push( builder->create( build::reduce< r >{ popvalue( red.vec ) } ) );
+            return std::move(*this);
+        }
+
         auto apply( action::ret r ) &&
         {
             auto fn = functions.back();
@@ -636,6 +1290,34 @@ namespace sc
             return std::move( *this );
         }
 
+        auto apply( action::fold ) &&
+        {
+            builder->enable_folding();
+            return std::move( *this );
+        }
+
+        auto apply( action::ssa_mode ) &&
+        {
+            if ( !ssa )
+                ssa = std::make_unique< sc::ssa::state >();
+            return std::move( *this );
+        }
+
+        auto apply( const action::seal_block &s ) &&
+        {
+            assert( ssa );
+            ssa->seal( s.name.empty() ? builder->GetInsertBlock() : block( s.name ) );
+            return std::move( *this );
+        }
+
+        auto apply( action::seal_all ) &&
+        {
+            assert( ssa );
+            for ( const auto &[ name, bb ] : blocks.left() )
+                ssa->seal( bb );
+            return std::move( *this );
+        }
+
         auto apply( action::push p ) &&
         {
             push( p.val );
@@ -649,12 +1331,107 @@ namespace sc
             return std::move( *this );
         }
 
-        auto apply( action::inspect ins ) &&
+        template< typename body_t >
+        auto apply( action::loop< body_t > l ) &&
+        {
+            assert( l.unroll && l.width );
+            value to = popvalue( l.count );
+            value iv = l.start ? l.start : llvm::ConstantInt::get( to->getType(), 0 );
+
+            if ( auto factor = l.unroll * l.width; factor > 1 )
+                iv = emit_loop( l, iv, to, factor );
+            emit_loop( l, iv, to, 1 ); // remainder
+            return std::move( *this );
+        }
+
+        // emits loop covering 'factor' steps per iteration, returns the
+        // induction variable, that is valid in the exit block
+        template< typename body_t >
+        value emit_loop( action::loop< body_t > &l, value from, value to, unsigned factor )
+        {
+            auto id     = fresh_label( "loop" );
+            auto pre    = builder->GetInsertBlock();
+            auto header = make_block( id + ".header" );
+            auto body   = make_block( id + ".body" );
+            auto latch  = make_block( id + ".latch" );
+            auto exit   = make_block( id + ".exit" );
+
+            builder->br( header );
+
+            enter( header );
+            auto ty = to->getType();
+            auto iv = builder->CreatePHI( ty, 2, "iv" );
+            iv->addIncoming( from, pre );
+
+            // the distance 'to - iv' is meaningful only when 'iv < to', a start
+            // past the count must not wrap into a huge trip count
+            auto stride = llvm::ConstantInt::get( ty, factor * l.step );
+            value cond = builder->cmp< predicate::ICMP_ULT >( iv, to );
+            if ( factor > 1 ) {
+                auto left = builder->cmp< predicate::ICMP_UGE >( builder->bin< binop::Sub >( to, iv ), stride );
+                cond = builder->bin< binop::And >( cond, left );
+            }
+            builder->condbr( cond, body, exit );
+            seal( body );
+
+            enter( body );
+            auto width = factor == 1 ? 1 : l.width;
+            for ( unsigned k = 0; k < factor / width; ++k ) {
+                value at = iv;
+                if ( k )
+                    at = builder->bin< binop::Add >( iv, llvm::ConstantInt::get( ty, k * width * l.step ) );
+                *this = l.body( std::move( *this ), at, width );
+            }
+            builder->br( latch );
+            seal( latch );
+
+            // the main loop never steps past 'to', the remainder may overflow
+            // the type when 'to' is close to its maximum
+            enter( latch );
+            auto next = builder->bin< binop::Add >( iv, stride );
+            iv->addIncoming( next, latch );
+            if ( factor == 1 && l.step > 1 )
+                builder->condbr( builder->cmp< predicate::ICMP_ULT >( next, iv ), exit, header );
+            else
+                builder->br( header );
+            seal( header );
+            seal( exit );
+
+            enter( exit );
+            return iv;
+        }
+
+        template< typename callback >
+        auto apply( action::inspect< callback > ins ) &&
         {
             ins.call( this );
             return std::move( *this );
         }
 
+        basicblock make_block( const std::string &name )
+        {
+            auto bb = llvm::BasicBlock::Create( sc::context(), name, functions.back() );
+            blocks.insert( name, bb );
+            return bb;
+        }
+
+        std::string fresh_label( const std::string &prefix )
+        {
+            return prefix + "." + std::to_string( labels++ );
+        }
+
+        void enter( basicblock bb )
+        {
+            current_block = bb;
+            builder->SetInsertPoint( bb );
+        }
+
+        void seal( basicblock bb )
+        {
+            if ( ssa )
+                ssa->seal( bb );
+        }
+
         basicblock block( const std::string &name )
         {
             assert( blocks.count(name) );
@@ -679,6 +1456,11 @@ namespace sc
 
         bool keep_stack = false;
         std::vector< value > stack;
+
+        // present in ssa mode, owns definitions of named variables
+        std::unique_ptr< sc::ssa::state > ssa;
+
+        unsigned labels = 0; // used to name generated blocks
     };
 
     namespace detail
@@ -686,7 +1468,7 @@ namespace sc
         template< typename Action >
         auto make_stack_builder( stack_builder &&builder, Action &&action )
         {
-            return std::move( builder ).apply( action );
+            return std::move( builder ).apply( std::forward< Action >( action ) );
         }
     } // namespace detail
 
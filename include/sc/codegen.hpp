@@ -0,0 +1,58 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <sc/target.hpp>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Module.h>
+
+#include <string>
+#include <vector>
+
+namespace sc
+{
+    using object_code = llvm::SmallVector< char, 0 >;
+
+    //
+    // Parallel native code generation. A module is split along function
+    // boundaries into partitions that are optimized and compiled to object
+    // files concurrently, each in its own context. Partitioning happens on
+    // the calling thread and the objects are ordered by partition index, so
+    // the output does not depend on the number of threads.
+    //
+    struct codegen
+    {
+        explicit codegen( opt_level lvl = opt_level::O2, unsigned nthreads = 0 )
+            : level( lvl ), threads( nthreads )
+        {}
+
+        // object code of each partition, the input module is left intact
+        std::vector< object_code > emit( const llvm::Module &m, unsigned partitions ) const;
+
+        // writes partitions to '<prefix>.<index>.o' files and returns their
+        // paths; linking them is left to the system linker, a file that cannot
+        // be written throws std::runtime_error
+        std::vector< std::string > write( const llvm::Module &m, unsigned partitions,
+                                          const std::string &prefix ) const;
+
+    private:
+        opt_level level;
+        unsigned threads; // zero stands for hardware concurrency
+    };
+
+} // namespace sc
@@ -27,6 +27,10 @@
     #if __clang_major__ >= 7
         #define SC_COMPILER_SUPPORTS_SYMMETRIC_TRANSFER 1
     #endif
+#elif SC_COMPILER_GCC
+    #if __GNUC__ >= 10
+        #define SC_COMPILER_SUPPORTS_SYMMETRIC_TRANSFER 1
+    #endif
 #endif
 #ifndef SC_COMPILER_SUPPORTS_SYMMETRIC_TRANSFER
     #define SC_COMPILER_SUPPORTS_SYMMETRIC_TRANSFER 0
@@ -17,6 +17,16 @@
 
 #pragma once
 
+#include <sc/warnings.hpp>
+
+SC_RELAX_WARNINGS
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/IR/Instruction.h>
+SC_UNRELAX_WARNINGS
+
+#include <cstddef>
+#include <vector>
+
 namespace sc
 {
     template< typename deleter >
@@ -37,6 +47,64 @@ namespace sc
         instruction inst;
     };
 
+    struct erase_stats
+    {
+        std::size_t erased = 0;
+        std::size_t duplicates = 0;
+        // uses by surviving values, replaced with undef
+        std::size_t replaced_uses = 0;
+    };
+
+    //
+    // Erases a set of dead instructions at once. Instructions are
+    // deduplicated on push; on erase all their operands are dropped in a
+    // single pass, so uses among the erased instructions vanish without
+    // any ordering constraints. Uses by surviving values are replaced with
+    // undef and the instructions are freed afterwards. The whole erase is
+    // linear in the number of instructions and their operands.
+    //
+    struct batch_eraser
+    {
+        using instruction = llvm::Instruction *;
+
+        batch_eraser() = default;
+        batch_eraser(const batch_eraser &) = delete;
+        batch_eraser &operator=(const batch_eraser &) = delete;
+
+        ~batch_eraser() { erase(); }
+
+        // returns false if the instruction is already scheduled
+        bool push(instruction inst);
+
+        [[nodiscard]] std::size_t size() const { return dead.size(); }
+        [[nodiscard]] bool empty() const { return dead.empty(); }
+
+        // erases pending instructions, returns statistics of this batch
+        erase_stats erase();
+
+        // the callback observes every instruction before it is freed
+        template< typename callback >
+        erase_stats erase(callback &&cb)
+        {
+            for (auto inst : dead)
+                cb(inst);
+            return erase();
+        }
+
+        // statistics accumulated over all batches
+        [[nodiscard]] const erase_stats &stats() const { return total; }
+
+    private:
+        llvm::SmallPtrSet< instruction, 32 > seen;
+        std::vector< instruction > dead;
+        std::size_t duplicates = 0;
+        erase_stats total;
+    };
+
+    //
+    // Collects instructions to be erased when the vector goes out of scope,
+    // the deleter is called for each of them right before it is freed.
+    //
     template< typename deleter >
     struct deferred_erase_vector
     {
@@ -44,11 +112,18 @@ namespace sc
         
         deferred_erase_vector(deleter d) : del(d) {}
 
-        void push(instruction i) { data.emplace_back(del, i); }
+        deferred_erase_vector(const deferred_erase_vector &) = delete;
+        deferred_erase_vector &operator=(const deferred_erase_vector &) = delete;
+
+        ~deferred_erase_vector() { eraser.erase(del); }
+
+        void push(instruction i) { eraser.push(i); }
+
+        [[nodiscard]] const erase_stats &stats() const { return eraser.stats(); }
 
     private:
         deleter del;
-        std::vector< deferred_erase< deleter > > data;
+        batch_eraser eraser;
     };
 
-} // namespace sc
\ No newline at end of file
+} // namespace sc
@@ -0,0 +1,119 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+
+namespace sc::detail
+{
+    //
+    // Thread-local recycling allocator for coroutine frames. Frames are
+    // rounded up to size classes of 64 bytes, freed frames are kept in
+    // per-class free lists of the freeing thread and reused by the next
+    // coroutine of the same class. Frames above 'max_size' bypass the pool,
+    // as does every frame allocated or freed after the pool of the thread has
+    // been destroyed (e.g. by another thread_local object at thread exit).
+    //
+    struct frame_pool
+    {
+        static constexpr std::size_t granularity = 64;
+        static constexpr std::size_t classes     = 16;
+        static constexpr std::size_t max_size    = granularity * classes;
+        static constexpr std::size_t max_cached  = 64; // frames kept per class
+
+        static void *allocate( std::size_t size )
+        {
+            if ( size > max_size || dead() )
+                return ::operator new( size );
+
+            auto &list = local().lists[ index( size ) ];
+            if ( auto head = list.head ) {
+                list.head = head->next;
+                --list.size;
+                return head;
+            }
+
+            return ::operator new( rounded( size ) );
+        }
+
+        static void deallocate( void *ptr, std::size_t size ) noexcept
+        {
+            if ( size > max_size || dead() ) {
+                ::operator delete( ptr );
+                return;
+            }
+
+            auto &list = local().lists[ index( size ) ];
+            if ( list.size == max_cached ) {
+                ::operator delete( ptr );
+                return;
+            }
+
+            list.head = ::new ( ptr ) block{ list.head };
+            ++list.size;
+        }
+
+    private:
+        struct block { block *next; };
+
+        struct free_list
+        {
+            block *head = nullptr;
+            std::size_t size = 0;
+        };
+
+        struct pool
+        {
+            pool() = default;
+            pool( const pool & ) = delete;
+            pool &operator=( const pool & ) = delete;
+
+            ~pool()
+            {
+                for ( auto &list : lists ) {
+                    while ( auto head = list.head ) {
+                        list.head = head->next;
+                        ::operator delete( head );
+                    }
+                    list.size = 0;
+                }
+                dead() = true;
+            }
+
+            std::array< free_list, classes > lists;
+        };
+
+        static std::size_t index( std::size_t size ) { return ( size - 1 ) / granularity; }
+        static std::size_t rounded( std::size_t size ) { return ( index( size ) + 1 ) * granularity; }
+
+        // trivially destructible, hence still usable after ~pool has run
+        static bool &dead() noexcept
+        {
+            thread_local bool destroyed = false;
+            return destroyed;
+        }
+
+        static pool &local()
+        {
+            thread_local pool frames;
+            return frames;
+        }
+    };
+
+} // namespace sc::detail
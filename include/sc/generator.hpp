@@ -17,6 +17,7 @@
 #pragma once
 
 #include "coroutine.hpp"
+#include "frame_pool.hpp"
 
 #include <concepts>
 #include <cstddef>
@@ -40,6 +41,13 @@ namespace sc
 
             generator_promise_type() = default;
 
+            // frames are recycled through a thread-local pool
+            static void *operator new(std::size_t size) { return frame_pool::allocate(size); }
+
+            static void operator delete(void *ptr, std::size_t size) noexcept {
+                frame_pool::deallocate(ptr, size);
+            }
+
             generator< T > get_return_object() noexcept;
 
             constexpr sc::suspend_always initial_suspend() const noexcept { return {}; }
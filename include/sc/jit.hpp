@@ -0,0 +1,100 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <sc/target.hpp>
+#include <sc/warnings.hpp>
+
+SC_RELAX_WARNINGS
+// included first and on its own: GCC 12 reports a null dereference in
+// llvm::ErrorList::join, the warning stays on for everything else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnull-dereference"
+#include <llvm/Support/Error.h>
+#pragma GCC diagnostic pop
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+SC_UNRELAX_WARNINGS
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace sc
+{
+    //
+    // In-memory object cache keyed by the hash of the module bitcode.
+    // Compiled objects of identical modules (or lazily extracted function
+    // partitions) are reused instead of compiled again. A cache may be
+    // shared by several jit instances.
+    //
+    struct object_cache : llvm::ObjectCache
+    {
+        void notifyObjectCompiled( const llvm::Module *m, llvm::MemoryBufferRef obj ) override;
+        std::unique_ptr< llvm::MemoryBuffer > getObject( const llvm::Module *m ) override;
+
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] std::size_t hits() const;
+
+    private:
+        using key_t = std::pair< std::uint64_t, std::uint64_t >;
+
+        static key_t hash( const llvm::Module *m );
+
+        mutable std::mutex mutex;
+        std::map< key_t, std::unique_ptr< llvm::MemoryBuffer > > objects;
+        std::map< const llvm::Module *, key_t > pending; // missed in getObject
+        std::size_t hit_count = 0;
+    };
+
+    //
+    // Executes modules built in the sc context in-process. Each added module
+    // is copied into a context owned by the jit, function bodies are
+    // optimized and compiled lazily on their first call.
+    //
+    struct jit
+    {
+        explicit jit( opt_level level = opt_level::none, std::shared_ptr< object_cache > cache = nullptr );
+        ~jit();
+
+        jit( const jit & ) = delete;
+        jit &operator=( const jit & ) = delete;
+
+        void add( const llvm::Module &m );
+
+        // address of a defined symbol, throws if the symbol is not found
+        std::uint64_t address( const std::string &name );
+
+        template< typename signature >
+        signature * lookup( const std::string &name )
+        {
+            return llvm::jitTargetAddressToFunction< signature * >( address( name ) );
+        }
+
+        [[nodiscard]] const std::shared_ptr< object_cache > &cache() const { return objects; }
+
+    private:
+        std::shared_ptr< object_cache > objects;
+        std::unique_ptr< llvm::orc::LLLazyJIT > engine;
+    };
+
+} // namespace sc
@@ -16,8 +16,21 @@
 
 #pragma once
 
+#include <llvm/ADT/StringMap.h>
 #include <llvm/IR/Metadata.h>
+#include <sc/context.hpp>
+
+#include <map>
 #include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace llvm
+{
+    class Argument;
+    class Function;
+} // namespace llvm
 
 namespace sc::meta
 {
@@ -35,14 +48,52 @@ namespace sc::meta
         constexpr ctag_t arguments = "sc.meta.arguments";
     } // namespace tag
 
+    // Distinct tags get a fresh node per value. Uniqued tags share a single
+    // node among all values tagged with the same string, the node is looked
+    // up in a per-context cache.
+    enum class mode { distinct, uniqued };
+
     node_t node( meta_str str );
 
+    // getters return views into metadata strings owned by the context,
+    // they stay valid as long as the context
     maybe_meta_str get_string( node_t n );
 
-    void set( llvm::Value *val, tag_t tag, meta_str meta = tag::none );
+    void set( llvm::Value *val, tag_t tag, meta_str meta = tag::none, mode m = mode::distinct );
 
     maybe_meta_str get( llvm::Value *val, tag_t tag );
 
+    //
+    // Typed payloads are stored as constants instead of strings. Integers and
+    // enums become integer constants of their width, other trivially copyable
+    // records an array of their bytes with padding cleared (records with
+    // padding are rejected where the compiler cannot clear it). Reading them
+    // back performs no parsing.
+    //
+    template< typename T >
+    concept typed_payload = std::is_integral_v< T > || std::is_enum_v< T > ||
+        ( std::is_class_v< T > && std::is_trivially_copyable_v< T > &&
+          !std::is_convertible_v< T, meta_str > );
+
+    node_t node( llvm::Constant *c );
+    llvm::Constant *get_constant( node_t n );
+
+    // whether the metadata kind was registered by a client rather than llvm
+    bool custom_kind( unsigned kind );
+
+    // payload node of an attachment in the sc::meta layout, null otherwise
+    node_t attached_payload( llvm::MDNode *attachment );
+
+    // untyped access to the payload node of a tag
+    void set_node( llvm::Value *val, tag_t tag, node_t payload, mode m = mode::distinct );
+    node_t get_node( llvm::Value *val, tag_t tag );
+
+    template< typed_payload T >
+    void set( llvm::Value *val, tag_t tag, const T &payload, mode m = mode::distinct );
+
+    template< typed_payload T >
+    std::optional< T > get( llvm::Value *val, tag_t tag );
+
     struct tuple
     {
         using meta_array = llvm::ArrayRef< llvm::Metadata * >;
@@ -51,13 +102,39 @@ namespace sc::meta
 
         template< typename Init >
         static inline llvm::MDTuple *create( long unsigned size, Init init );
+
+        static llvm::MDTuple *uniqued( meta_str str );
     };
 
+    // forgets uniqued nodes cached for the context, invoked by sc::init
+    void reset( context_ref ctx );
+
     struct argument
     {
         static void set( llvm::Argument *arg, meta_str str );
         static void set( llvm::Argument *arg, node_t node );
         static maybe_meta_str get( llvm::Argument *arg );
+
+        // sets leading arguments of the function at once, the argument tuple
+        // is created only when missing and otherwise updated in place
+        static void set_all( llvm::Function *fn, std::span< const meta_str > strs );
+        static void set_all( llvm::Function *fn, llvm::ArrayRef< node_t > nodes );
+
+        //
+        // Collects argument metadata of many functions, commit() then
+        // writes the argument tuple of each function exactly once.
+        //
+        struct batch
+        {
+            void set( llvm::Argument *arg, meta_str str );
+            void set( llvm::Argument *arg, node_t node );
+
+            void commit();
+
+        private:
+            std::map< llvm::Function *, std::vector< node_t > > functions;
+            llvm::StringMap< node_t > nodes; // avoids repeated uniquing
+        };
     };
 
 } // namespace sc::meta
@@ -16,8 +16,13 @@
 
 #pragma once
 
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
 #include <sc/context.hpp>
 
+#include <cstring>
+#include <type_traits>
+
 namespace sc::meta
 {
     llvm::MDTuple *tuple::create( const meta_array &arr )
@@ -34,4 +39,76 @@ namespace sc::meta
         return llvm::MDTuple::getDistinct( sc::context(), values );
     }
 
+    namespace detail
+    {
+        template< typename T >
+        constexpr bool integral_payload = std::is_integral_v< T > || std::is_enum_v< T >;
+
+        template< typename T >
+        struct raw_type { using type = T; };
+
+        template< typename T > requires std::is_enum_v< T >
+        struct raw_type< T > { using type = std::underlying_type_t< T >; };
+
+        template< typename T >
+        llvm::Constant *encode( const T &payload )
+        {
+            auto &ctx = sc::context();
+            if constexpr ( std::is_same_v< T, bool > ) {
+                return llvm::ConstantInt::getBool( ctx, payload );
+            } else if constexpr ( integral_payload< T > ) {
+                using raw = typename raw_type< T >::type;
+                auto ty = llvm::IntegerType::get( ctx, sizeof( T ) * 8 );
+                auto bits = static_cast< uint64_t >( static_cast< raw >( payload ) );
+                return llvm::ConstantInt::get( ty, bits, std::is_signed_v< raw > );
+            } else {
+                // padding bytes are indeterminate, equal records would not be
+                // uniqued to the same node
+                llvm::SmallVector< uint8_t, sizeof( T ) > bytes( sizeof( T ) );
+            #if __has_builtin( __builtin_clear_padding )
+                T copy = payload;
+                __builtin_clear_padding( &copy );
+                std::memcpy( bytes.data(), &copy, sizeof( T ) );
+            #else
+                static_assert( std::has_unique_object_representations_v< T >,
+                    "record payloads must not contain padding" );
+                std::memcpy( bytes.data(), &payload, sizeof( T ) );
+            #endif
+                return llvm::ConstantDataArray::get( ctx, bytes );
+            }
+        }
+
+        template< typename T >
+        std::optional< T > decode( llvm::Constant *c )
+        {
+            if constexpr ( integral_payload< T > ) {
+                auto i = llvm::dyn_cast_or_null< llvm::ConstantInt >( c );
+                constexpr auto width = std::is_same_v< T, bool > ? 1 : sizeof( T ) * 8;
+                if ( !i || i->getBitWidth() != width )
+                    return std::nullopt;
+                return static_cast< T >( i->getZExtValue() );
+            } else {
+                auto arr = llvm::dyn_cast_or_null< llvm::ConstantDataArray >( c );
+                if ( !arr || arr->getRawDataValues().size() != sizeof( T ) )
+                    return std::nullopt;
+                T payload;
+                std::memcpy( &payload, arr->getRawDataValues().data(), sizeof( T ) );
+                return payload;
+            }
+        }
+
+    } // namespace detail
+
+    template< typed_payload T >
+    void set( llvm::Value *val, tag_t tag, const T &payload, mode m )
+    {
+        set_node( val, tag, node( detail::encode( payload ) ), m );
+    }
+
+    template< typed_payload T >
+    std::optional< T > get( llvm::Value *val, tag_t tag )
+    {
+        return detail::decode< T >( get_constant( get_node( val, tag ) ) );
+    }
+
 } // namespace sc::meta
@@ -0,0 +1,101 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/ValueHandle.h>
+
+#include <sc/meta.hpp>
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace sc::meta
+{
+    //
+    // Reverse index from metadata tags (and tag payloads) to tagged values of
+    // a module. The index is built lazily by a single scan of the module and
+    // then kept up to date by meta::set paths. Entries are verified when
+    // queried, so values that were erased or retagged behind the back of the
+    // index are dropped, and lookups cost the size of their result.
+    //
+    // Tags attached by other means than sc::meta, or to instructions not yet
+    // inserted into a function, are found only after invalidate().
+    //
+    // Indices of distinct modules may live on distinct threads, a single
+    // index is not thread-safe.
+    //
+    struct index
+    {
+        explicit index( llvm::Module &m );
+        ~index();
+
+        index( const index & ) = delete;
+        index &operator=( const index & ) = delete;
+
+        // values carrying the tag, arguments are indexed under tag::arguments
+        std::vector< llvm::Value * > values( tag_t tag );
+
+        // values carrying the tag with the given payload
+        std::vector< llvm::Value * > values( tag_t tag, meta_str payload );
+
+        template< typed_payload T >
+        std::vector< llvm::Value * > values( tag_t tag, const T &payload )
+        {
+            return values( tag, node( detail::encode( payload ) ) );
+        }
+
+        std::vector< llvm::Value * > values( tag_t tag, node_t payload );
+
+        // forces a rescan of the module on the next query
+        void invalidate();
+
+        // invoked by meta::set paths on every change of a tag
+        static void notify( llvm::Value *val, tag_t tag, node_t payload );
+
+    private:
+        struct bucket
+        {
+            void insert( llvm::Value *val );
+            void erase( std::size_t pos );
+
+            struct entry
+            {
+                llvm::WeakVH handle;
+                llvm::Value *key; // address the entry was inserted under
+            };
+
+            std::vector< entry > entries;
+            std::unordered_map< llvm::Value *, std::size_t > position;
+        };
+
+        void insert( llvm::Value *val, tag_t tag, node_t payload );
+        void rebuild();
+
+        template< typename valid_t >
+        std::vector< llvm::Value * > collect( bucket &b, valid_t valid );
+
+        llvm::Module &module;
+        bool stale = true;
+
+        llvm::StringMap< bucket > tags;
+        llvm::StringMap< std::unordered_map< node_t, bucket > > payloads;
+    };
+
+} // namespace sc::meta
@@ -0,0 +1,71 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/ValueHandle.h>
+
+#include <sc/types.hpp>
+
+#include <cstddef>
+#include <unordered_map>
+
+namespace sc
+{
+    using basicblock = llvm::BasicBlock *;
+
+    // pure expression computed by a single instruction
+    struct expression
+    {
+        unsigned opcode;
+        unsigned pred = 0; // predicate of comparisons
+        type ty;           // result type
+        value lhs, rhs = nullptr;
+
+        bool operator==( const expression & ) const = default;
+    };
+
+    struct fold_stats
+    {
+        std::size_t simplified = 0; // replaced by simpler existing value
+        std::size_t reused     = 0; // replaced by previously emitted instruction
+
+        [[nodiscard]] std::size_t elided() const { return simplified + reused; }
+    };
+
+    //
+    // Local value numbering: per-block hash-consing table of emitted pure
+    // instructions. A value is returned only while it still resides in the
+    // block it was emitted into and still computes the looked up expression.
+    //
+    struct value_numbering
+    {
+        [[nodiscard]] value lookup( basicblock bb, const expression &e ) const;
+        void insert( basicblock bb, const expression &e, value v );
+
+        void clear() { table.clear(); }
+        [[nodiscard]] std::size_t size() const { return table.size(); }
+
+    private:
+        using key_t = std::pair< basicblock, expression >;
+
+        struct hash { std::size_t operator()( const key_t &key ) const; };
+
+        std::unordered_map< key_t, llvm::WeakVH, hash > table;
+    };
+
+} // namespace sc
@@ -0,0 +1,258 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "coroutine.hpp"
+#include "frame_pool.hpp"
+
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#if !SC_COMPILER_SUPPORTS_SYMMETRIC_TRANSFER
+    #error sc::recursive_generator requires a compiler with symmetric transfer
+#endif
+
+namespace sc
+{
+    //
+    // Generator that can 'co_yield' another recursive generator, elements of
+    // the nested generator are delivered directly to the consumer. The
+    // consumer always resumes the innermost active generator and a finished
+    // generator transfers control to its parent, so each element costs a
+    // single resume regardless of the nesting depth.
+    //
+    template< typename T >
+    struct recursive_generator;
+
+    namespace detail
+    {
+        template< typename T >
+        struct recursive_generator_promise_type {
+            using value_type     = std::remove_reference_t< T >;
+            using reference_type = std::conditional_t< std::is_reference_v< T >, T, T& >;
+            using pointer_type   = value_type*;
+
+            using handle = sc::coroutine_handle< recursive_generator_promise_type >;
+
+            recursive_generator_promise_type() noexcept : _root(this) {}
+
+            static void *operator new(std::size_t size) { return frame_pool::allocate(size); }
+
+            static void operator delete(void *ptr, std::size_t size) noexcept {
+                frame_pool::deallocate(ptr, size);
+            }
+
+            recursive_generator< T > get_return_object() noexcept;
+
+            constexpr sc::suspend_always initial_suspend() const noexcept { return {}; }
+
+            struct final_awaiter {
+                constexpr bool await_ready() const noexcept { return false; }
+
+                sc::coroutine_handle<> await_suspend(handle h) noexcept {
+                    auto &promise = h.promise();
+                    if (promise._parent) {
+                        promise._root->_leaf = promise._parent;
+                        return promise._parent;
+                    }
+                    return sc::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            final_awaiter final_suspend() const noexcept { return {}; }
+
+            sc::suspend_always yield_value(value_type& value) noexcept {
+                _root->_value = std::addressof(value);
+                return {};
+            }
+
+            sc::suspend_always yield_value(value_type&& value) noexcept {
+                _root->_value = std::addressof(value);
+                return {};
+            }
+
+            struct nested_awaiter {
+                explicit nested_awaiter(recursive_generator< T > &&nested) noexcept
+                    : _nested(std::move(nested)) {}
+
+                bool await_ready() const noexcept { return !_nested._coroutine; }
+
+                handle await_suspend(handle parent) noexcept {
+                    auto child = _nested._coroutine;
+                    auto &promise = child.promise();
+                    promise._root = parent.promise()._root;
+                    promise._parent = parent;
+                    promise._root->_leaf = child;
+                    return child;
+                }
+
+                void await_resume() {
+                    if (_nested._coroutine) {
+                        _nested._coroutine.promise().rethrow_if_exception();
+                    }
+                }
+
+              private:
+                recursive_generator< T > _nested;
+            };
+
+            nested_awaiter yield_value(recursive_generator< T > &&nested) noexcept {
+                return nested_awaiter{ std::move(nested) };
+            }
+
+            nested_awaiter yield_value(recursive_generator< T > &nested) noexcept {
+                return nested_awaiter{ std::move(nested) };
+            }
+
+            void unhandled_exception() { _exception = std::current_exception(); }
+
+            void return_void() {}
+
+            reference_type value() const noexcept { return static_cast< reference_type >(*_root->_value); }
+
+            template< typename U >
+            sc::suspend_never await_transform(U&& value) = delete;
+
+            void rethrow_if_exception() {
+                if (_exception) {
+                    std::rethrow_exception(_exception);
+                }
+            }
+
+            // resumes the innermost active generator
+            void pull() { _leaf.resume(); }
+
+          private:
+            handle _leaf;
+            recursive_generator_promise_type *_root;
+            handle _parent = nullptr;
+
+            pointer_type _value = nullptr;
+            std::exception_ptr _exception;
+        };
+
+        struct recursive_generator_sentinel {};
+
+        template< typename T >
+        struct recursive_generator_iterator {
+            using promise_type     = recursive_generator_promise_type< T >;
+            using coroutine_handle = sc::coroutine_handle< promise_type >;
+
+            using iterator_category = std::input_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = typename promise_type::value_type;
+            using reference         = typename promise_type::reference_type;
+            using pointer           = typename promise_type::pointer_type;
+
+            recursive_generator_iterator() noexcept = default;
+
+            explicit recursive_generator_iterator(coroutine_handle coroutine) noexcept
+                : _coroutine(coroutine) {}
+
+            friend bool operator==(const recursive_generator_iterator& it, recursive_generator_sentinel) noexcept {
+                return !it._coroutine || it._coroutine.done();
+            }
+
+            friend bool operator!=(const recursive_generator_iterator& it, recursive_generator_sentinel s) noexcept {
+                return !(it == s);
+            }
+
+            recursive_generator_iterator& operator++() {
+                _coroutine.promise().pull();
+                if (_coroutine.done()) {
+                    _coroutine.promise().rethrow_if_exception();
+                }
+                return *this;
+            }
+
+            void operator++(int) { (void) operator++(); }
+
+            reference operator*() const noexcept { return _coroutine.promise().value(); }
+
+            pointer operator->() const noexcept { return std::addressof(operator*()); }
+
+          private:
+            coroutine_handle _coroutine = nullptr;
+        };
+
+    } // namespace detail
+
+    template< typename T >
+    struct [[nodiscard]] recursive_generator {
+        using iterator         = detail::recursive_generator_iterator< T >;
+        using promise_type     = detail::recursive_generator_promise_type< T >;
+        using coroutine_handle = sc::coroutine_handle< promise_type >;
+
+        recursive_generator(recursive_generator&& other) noexcept
+            : _coroutine(other._coroutine) {
+            other._coroutine = nullptr;
+        }
+
+        recursive_generator(const recursive_generator& other) = delete;
+
+        ~recursive_generator() {
+            if (_coroutine) {
+                _coroutine.destroy();
+            }
+        }
+
+        recursive_generator& operator=(recursive_generator other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        iterator begin() {
+            if (_coroutine) {
+                _coroutine.promise().pull();
+                if (_coroutine.done()) {
+                    _coroutine.promise().rethrow_if_exception();
+                }
+            }
+
+            return iterator{ _coroutine };
+        }
+
+        detail::recursive_generator_sentinel end() noexcept { return {}; }
+
+        void swap(recursive_generator& other) noexcept { std::swap(_coroutine, other._coroutine); }
+
+      private:
+        friend struct detail::recursive_generator_promise_type< T >;
+
+        explicit recursive_generator(coroutine_handle coroutine)
+            : _coroutine(coroutine) {}
+
+        coroutine_handle _coroutine = nullptr;
+    };
+
+    namespace detail
+    {
+        template< typename T >
+        recursive_generator< T > recursive_generator_promise_type< T >::get_return_object() noexcept {
+            auto self = sc::coroutine_handle< recursive_generator_promise_type< T > >::from_promise(*this);
+            _leaf = self;
+            return recursive_generator< T >{ self };
+        }
+    } // namespace detail
+
+} // namespace sc
@@ -0,0 +1,93 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Module.h>
+
+#include <sc/types.hpp>
+
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+
+namespace sc
+{
+    using function_type = llvm::FunctionType *;
+
+    //
+    // Declaration of a runtime hook together with its argument coercion
+    // plan. The plan remembers for every parameter which cast converts a
+    // given source type, so repeated call sites skip the type queries.
+    //
+    struct runtime_function
+    {
+        runtime_function( llvm::FunctionCallee callee );
+
+        // emits a call at the insertion point of the builder, arguments are
+        // casted to the parameter types as needed
+        llvm::CallInst * call( llvm::IRBuilderBase &irb, std::span< const value > args ) const;
+
+        [[nodiscard]] llvm::FunctionCallee callee() const { return fn; }
+        [[nodiscard]] function_type signature() const { return fty; }
+
+    private:
+        // no cast is needed when source and parameter types are equal
+        static constexpr unsigned no_cast = 0;
+
+        struct coercion
+        {
+            type from;
+            unsigned op; // llvm::Instruction::CastOps or no_cast
+        };
+
+        value coerce( llvm::IRBuilderBase &irb, unsigned idx, value arg ) const;
+
+        llvm::FunctionCallee fn;
+        function_type fty;
+
+        // per parameter cache of seen source types, usually a single entry
+        mutable llvm::SmallVector< llvm::SmallVector< coercion, 2 >, 4 > plan;
+    };
+
+    //
+    // Per-module registry of runtime functions. Declarations are created
+    // on the first request and shared by all later requests of the same
+    // name and signature; returned references stay valid for the lifetime
+    // of the registry.
+    //
+    struct runtime
+    {
+        explicit runtime( llvm::Module *m ) : module( m ) {}
+
+        const runtime_function& get( const std::string &name, function_type ty );
+        const runtime_function& get( const std::string &name, type ret, const std::vector< type > &args );
+
+        [[nodiscard]] std::size_t size() const { return functions.size(); }
+
+    private:
+        llvm::Module *module;
+
+        std::map< std::pair< std::string, function_type >, std::unique_ptr< runtime_function > > functions;
+    };
+
+} // namespace sc
@@ -0,0 +1,88 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "coroutine.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sc
+{
+    //
+    // Work-stealing thread pool for coroutines. A coroutine moves onto the
+    // pool by awaiting 'schedule()'. Work scheduled from a worker stays on
+    // its local queue, which the worker drains newest first, while idle
+    // workers steal the oldest work of the others.
+    //
+    struct scheduler {
+        explicit scheduler(unsigned nthreads = std::thread::hardware_concurrency());
+
+        // finishes the queued work and joins the workers
+        ~scheduler();
+
+        scheduler(const scheduler&) = delete;
+        scheduler& operator=(const scheduler&) = delete;
+
+        struct schedule_operation {
+            constexpr bool await_ready() const noexcept { return false; }
+            void await_suspend(sc::coroutine_handle<> h) { _scheduler.enqueue(h); }
+            void await_resume() const noexcept {}
+
+            scheduler &_scheduler;
+        };
+
+        [[nodiscard]] schedule_operation schedule() noexcept { return { *this }; }
+
+        [[nodiscard]] std::size_t size() const noexcept { return _workers.size(); }
+
+        // number of coroutines taken from another worker's queue
+        [[nodiscard]] std::size_t steals() const noexcept {
+            return _steals.load(std::memory_order_relaxed);
+        }
+
+      private:
+        struct worker {
+            std::mutex mutex;
+            std::deque< sc::coroutine_handle<> > queue;
+        };
+
+        void enqueue(sc::coroutine_handle<> h);
+        void run(std::size_t idx);
+
+        sc::coroutine_handle<> pop(std::size_t idx);
+        sc::coroutine_handle<> steal(std::size_t idx);
+
+        std::vector< std::unique_ptr< worker > > _workers;
+        std::vector< std::thread > _threads;
+
+        std::mutex _sleep_mutex;
+        std::condition_variable _wake;
+        std::atomic< std::size_t > _pending{ 0 };
+        std::atomic< std::size_t > _next{ 0 };
+        std::atomic< std::size_t > _steals{ 0 };
+        bool _stop = false;
+    };
+
+} // namespace sc
@@ -0,0 +1,137 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <sc/annotation.hpp>
+#include <sc/meta.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sc::meta
+{
+    //
+    // Persistent store of sc::meta tags and global annotations of a module.
+    // Values are identified by stable ids: global values by name, arguments
+    // by their number and instructions by their ordinal in the function.
+    // Unnamed global values and instructions outside of a function have no
+    // stable id and are not stored.
+    //
+    // Ordinals of a function are numbered on its first query and renumbered
+    // when a queried instruction is missing. After instructions were erased
+    // or moved, call 'invalidate' to renumber.
+    //
+    // The file holds a sorted array of fixed-size entries followed by a
+    // table of deduplicated strings and payload bytes. A loaded sidecar maps
+    // the file and answers lookups by binary search, no IR metadata is
+    // materialized.
+    //
+    struct sidecar
+    {
+        // stores metadata of the module, throws std::runtime_error on failure
+        static void write( llvm::Module &m, const std::string &path );
+
+        // throws std::runtime_error on a missing or malformed file
+        static sidecar load( const std::string &path );
+
+        maybe_meta_str get( llvm::Value *val, tag_t tag );
+
+        template< typed_payload T >
+        std::optional< T > get( llvm::Value *val, tag_t tag );
+
+        std::vector< annotation > annotations( llvm::GlobalValue *gv );
+
+        [[nodiscard]] std::size_t size() const { return count; }
+
+        // drops cached instruction ordinals
+        void invalidate() { ordinals.clear(); }
+
+        enum class slot_kind : uint16_t { global, argument, instruction };
+        enum class payload_kind : uint16_t { string, integer, bytes, annotation };
+
+        struct entry
+        {
+            uint32_t owner, owner_size;     // name of the global value
+            uint32_t tag, tag_size;
+            uint32_t payload, payload_size; // string or raw payload bytes
+            slot_kind kind;
+            payload_kind data;
+            uint32_t slot;                  // argument number or ordinal
+        };
+
+    private:
+        explicit sidecar( std::unique_ptr< llvm::MemoryBuffer > buffer );
+
+        struct key
+        {
+            llvm::StringRef owner;
+            slot_kind kind;
+            uint32_t slot;
+        };
+
+        std::optional< key > id( llvm::Value *val );
+        std::pair< const entry *, const entry * > find( const key &k, tag_t tag ) const;
+        const entry * find_one( llvm::Value *val, tag_t tag, payload_kind data );
+
+        [[nodiscard]] llvm::StringRef string( uint32_t off, uint32_t size ) const;
+
+        std::unique_ptr< llvm::MemoryBuffer > buffer;
+        const entry *entries = nullptr;
+        std::size_t count = 0;
+        const char *strings = nullptr;
+
+        // ordinals of instructions, computed on the first query of a function
+        std::unordered_map< const llvm::Function *,
+                            std::unordered_map< const llvm::Instruction *, uint32_t > > ordinals;
+    };
+
+    template< typed_payload T >
+    std::optional< T > sidecar::get( llvm::Value *val, tag_t tag )
+    {
+        constexpr bool integral = std::is_integral_v< T > || std::is_enum_v< T >;
+        auto e = find_one( val, tag, integral ? payload_kind::integer : payload_kind::bytes );
+        if ( !e )
+            return std::nullopt;
+
+        auto raw = string( e->payload, e->payload_size );
+        if constexpr ( integral ) {
+            // integers are stored as their width followed by 64-bit value
+            constexpr uint32_t width = std::is_same_v< T, bool > ? 1 : sizeof( T ) * 8;
+            uint32_t bits;
+            uint64_t value;
+            std::memcpy( &bits, raw.data(), sizeof( bits ) );
+            std::memcpy( &value, raw.data() + sizeof( bits ), sizeof( value ) );
+            if ( bits != width )
+                return std::nullopt;
+            return static_cast< T >( value );
+        } else {
+            if ( raw.size() != sizeof( T ) )
+                return std::nullopt;
+            T payload;
+            std::memcpy( &payload, raw.data(), sizeof( T ) );
+            return payload;
+        }
+    }
+
+} // namespace sc::meta
@@ -0,0 +1,86 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/ValueHandle.h>
+
+#include <sc/types.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sc::ssa
+{
+    using basicblock = llvm::BasicBlock *;
+    using phi_node   = llvm::PHINode *;
+
+    //
+    // On-the-fly construction of SSA form for named variables following
+    // Braun et al., Simple and Efficient Construction of Static Single
+    // Assignment Form (CC 2013).
+    //
+    // Variables are written and read per basic block, phis are created
+    // lazily when a read reaches a join point. A block has to be sealed once
+    // all of its predecessors are known (i.e. their terminators are emitted),
+    // reads in unsealed blocks produce incomplete phis that are completed
+    // during sealing. Trivial phis are removed as soon as they are detected.
+    //
+    struct state
+    {
+        void declare( const std::string &var, type ty );
+        [[nodiscard]] bool declared( const std::string &var ) const;
+
+        void write( const std::string &var, basicblock bb, value val );
+        value read( const std::string &var, basicblock bb );
+
+        void seal( basicblock bb );
+        [[nodiscard]] bool sealed( basicblock bb ) const;
+
+    private:
+        using var_id = unsigned;
+
+        var_id id( const std::string &var ) const;
+
+        void write( var_id var, basicblock bb, value val );
+        value read( var_id var, basicblock bb );
+        value read_recursive( var_id var, basicblock bb );
+
+        phi_node make_phi( var_id var, basicblock bb );
+        value add_phi_operands( var_id var, phi_node phi );
+        value try_remove_trivial_phi( phi_node phi );
+
+        std::unordered_map< std::string, var_id > ids;
+        std::vector< std::pair< std::string, type > > vars;
+
+        // current definition of a variable at the end of a block, the handle
+        // follows replacements of removed trivial phis
+        std::map< std::pair< basicblock, var_id >, llvm::WeakTrackingVH > defs;
+
+        std::map< basicblock, std::vector< std::pair< var_id, phi_node > > > incomplete;
+        std::set< basicblock > sealed_blocks;
+
+        // phis introduced by the construction, only those may be removed
+        std::set< phi_node > phis;
+    };
+
+} // namespace sc::ssa
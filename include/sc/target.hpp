@@ -0,0 +1,43 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+
+namespace llvm
+{
+    class Module;
+    class TargetMachine;
+} // namespace llvm
+
+namespace sc
+{
+    // optimization pipeline run before native code generation
+    enum class opt_level { none, O1, O2, O3 };
+
+    // registers the host target, its assembly printer and parser; safe to
+    // call repeatedly and from multiple threads
+    void init_native_target();
+
+    // runs the default module pipeline of the given level
+    void optimize( llvm::Module &m, opt_level level );
+
+    // target machine of the host triple with generic cpu, the object code
+    // does not depend on the machine that produced it
+    std::unique_ptr< llvm::TargetMachine > native_target_machine( opt_level level );
+
+} // namespace sc
@@ -0,0 +1,345 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "coroutine.hpp"
+#include "frame_pool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if !SC_COMPILER_SUPPORTS_SYMMETRIC_TRANSFER
+    #error sc::task requires a compiler with symmetric transfer
+#endif
+
+namespace sc
+{
+    //
+    // Lazily started coroutine producing a single value. A task starts when
+    // it is awaited and resumes its awaiter on completion, on the thread it
+    // completed on.
+    //
+    template< typename T = void >
+    struct task;
+
+    namespace detail
+    {
+        struct task_promise_base {
+            static void *operator new(std::size_t size) { return frame_pool::allocate(size); }
+
+            static void operator delete(void *ptr, std::size_t size) noexcept {
+                frame_pool::deallocate(ptr, size);
+            }
+
+            constexpr sc::suspend_always initial_suspend() const noexcept { return {}; }
+
+            struct final_awaiter {
+                constexpr bool await_ready() const noexcept { return false; }
+
+                template< typename promise_type >
+                sc::coroutine_handle<> await_suspend(sc::coroutine_handle< promise_type > h) noexcept {
+                    if (auto continuation = h.promise()._continuation) {
+                        return continuation;
+                    }
+                    return sc::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            final_awaiter final_suspend() const noexcept { return {}; }
+
+            void unhandled_exception() noexcept { _exception = std::current_exception(); }
+
+            void rethrow_if_exception() const {
+                if (_exception) {
+                    std::rethrow_exception(_exception);
+                }
+            }
+
+            sc::coroutine_handle<> _continuation = nullptr;
+            std::exception_ptr _exception;
+        };
+
+        template< typename T >
+        struct task_promise : task_promise_base {
+            task< T > get_return_object() noexcept;
+
+            template< typename U >
+            void return_value(U &&value) { _value.emplace(std::forward< U >(value)); }
+
+            T& result() & {
+                rethrow_if_exception();
+                return *_value;
+            }
+
+            T&& result() && {
+                rethrow_if_exception();
+                return std::move(*_value);
+            }
+
+          private:
+            std::optional< T > _value;
+        };
+
+        template<>
+        struct task_promise< void > : task_promise_base {
+            task< void > get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void result() const { rethrow_if_exception(); }
+        };
+
+    } // namespace detail
+
+    template< typename T >
+    struct [[nodiscard]] task {
+        using promise_type     = detail::task_promise< T >;
+        using coroutine_handle = sc::coroutine_handle< promise_type >;
+
+        task(task&& other) noexcept
+            : _coroutine(std::exchange(other._coroutine, nullptr)) {}
+
+        task(const task&) = delete;
+
+        ~task() {
+            if (_coroutine) {
+                _coroutine.destroy();
+            }
+        }
+
+        task& operator=(task other) noexcept {
+            std::swap(_coroutine, other._coroutine);
+            return *this;
+        }
+
+        [[nodiscard]] bool done() const noexcept { return !_coroutine || _coroutine.done(); }
+
+        struct awaiter {
+            bool await_ready() const noexcept { return !_coroutine || _coroutine.done(); }
+
+            sc::coroutine_handle<> await_suspend(sc::coroutine_handle<> awaiting) noexcept {
+                _coroutine.promise()._continuation = awaiting;
+                return _coroutine;
+            }
+
+            decltype(auto) await_resume() { return std::move(_coroutine.promise()).result(); }
+
+            coroutine_handle _coroutine;
+        };
+
+        awaiter operator co_await() && noexcept { return { _coroutine }; }
+        awaiter operator co_await() & noexcept { return { _coroutine }; }
+
+        // result of a finished task
+        decltype(auto) result() { return std::move(_coroutine.promise()).result(); }
+
+      private:
+        friend promise_type;
+
+        explicit task(coroutine_handle coroutine) : _coroutine(coroutine) {}
+
+        coroutine_handle _coroutine = nullptr;
+    };
+
+    namespace detail
+    {
+        template< typename T >
+        task< T > task_promise< T >::get_return_object() noexcept {
+            return task< T >{ sc::coroutine_handle< task_promise< T > >::from_promise(*this) };
+        }
+
+        inline task< void > task_promise< void >::get_return_object() noexcept {
+            return task< void >{ sc::coroutine_handle< task_promise< void > >::from_promise(*this) };
+        }
+
+        //
+        // Coroutine driving a single awaitable to completion, it reports the
+        // completion through a callback invoked after the coroutine suspended
+        // for the last time.
+        //
+        template< typename notify_t >
+        struct completion {
+            struct promise_type {
+                static void *operator new(std::size_t size) { return frame_pool::allocate(size); }
+
+                static void operator delete(void *ptr, std::size_t size) noexcept {
+                    frame_pool::deallocate(ptr, size);
+                }
+
+                completion get_return_object() noexcept {
+                    return completion{ sc::coroutine_handle< promise_type >::from_promise(*this) };
+                }
+
+                constexpr sc::suspend_always initial_suspend() const noexcept { return {}; }
+
+                struct final_awaiter {
+                    constexpr bool await_ready() const noexcept { return false; }
+
+                    sc::coroutine_handle<> await_suspend(sc::coroutine_handle< promise_type > h) noexcept {
+                        return h.promise()._notify->notify();
+                    }
+
+                    void await_resume() noexcept {}
+                };
+
+                final_awaiter final_suspend() const noexcept { return {}; }
+
+                // failures are kept in the awaited task
+                void unhandled_exception() noexcept {}
+
+                void return_void() noexcept {}
+
+                notify_t *_notify = nullptr;
+            };
+
+            using handle = sc::coroutine_handle< promise_type >;
+
+            completion(completion&& other) noexcept
+                : _coroutine(std::exchange(other._coroutine, nullptr)) {}
+
+            ~completion() {
+                if (_coroutine) {
+                    _coroutine.destroy();
+                }
+            }
+
+            void start(notify_t &notify) {
+                _coroutine.promise()._notify = &notify;
+                _coroutine.resume();
+            }
+
+          private:
+            explicit completion(handle coroutine) : _coroutine(coroutine) {}
+
+            handle _coroutine;
+        };
+
+        template< typename notify_t, typename T >
+        completion< notify_t > make_completion(task< T > &t) {
+            co_await t;
+        }
+
+        // counts down finished tasks, the last one resumes the awaiter
+        struct when_all_counter {
+            explicit when_all_counter(std::size_t count) : _count(count + 1) {}
+
+            sc::coroutine_handle<> notify() noexcept {
+                if (_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    return _awaiting;
+                }
+                return sc::noop_coroutine();
+            }
+
+            // returns false if all tasks already finished
+            bool try_await(sc::coroutine_handle<> awaiting) noexcept {
+                _awaiting = awaiting;
+                return _count.fetch_sub(1, std::memory_order_acq_rel) > 1;
+            }
+
+            std::atomic< std::size_t > _count;
+            sc::coroutine_handle<> _awaiting = nullptr;
+        };
+
+        template< typename T >
+        struct when_all_awaiter {
+            explicit when_all_awaiter(std::vector< task< T > > &tasks)
+                : _tasks(tasks), _counter(tasks.size())
+            {}
+
+            bool await_ready() const noexcept { return _tasks.empty(); }
+
+            bool await_suspend(sc::coroutine_handle<> awaiting) {
+                _joins.reserve(_tasks.size());
+                for (auto &t : _tasks) {
+                    _joins.push_back(make_completion< when_all_counter >(t));
+                }
+                for (auto &join : _joins) {
+                    join.start(_counter);
+                }
+                return _counter.try_await(awaiting);
+            }
+
+            void await_resume() noexcept {}
+
+            std::vector< task< T > > &_tasks;
+            when_all_counter _counter;
+            std::vector< completion< when_all_counter > > _joins;
+        };
+
+        struct sync_wait_event {
+            sc::coroutine_handle<> notify() noexcept {
+                // notified under the lock, the waiter destroys the event as
+                // soon as it observes '_done'
+                std::lock_guard lock(_mutex);
+                _done = true;
+                _cv.notify_all();
+                return sc::noop_coroutine();
+            }
+
+            void wait() {
+                std::unique_lock lock(_mutex);
+                _cv.wait(lock, [&] { return _done; });
+            }
+
+            std::mutex _mutex;
+            std::condition_variable _cv;
+            bool _done = false;
+        };
+
+    } // namespace detail
+
+    // awaits all tasks, results are ordered as the tasks
+    template< typename T >
+    task< std::conditional_t< std::is_void_v< T >, void, std::vector< T > > >
+    when_all(std::vector< task< T > > tasks) {
+        co_await detail::when_all_awaiter< T >(tasks);
+
+        if constexpr (std::is_void_v< T >) {
+            for (auto &t : tasks) {
+                t.result();
+            }
+        } else {
+            std::vector< T > results;
+            results.reserve(tasks.size());
+            for (auto &t : tasks) {
+                results.push_back(t.result());
+            }
+            co_return results;
+        }
+    }
+
+    // blocks the calling thread until the task finishes
+    template< typename T >
+    T sync_wait(task< T > &&t) {
+        detail::sync_wait_event event;
+        auto waiter = detail::make_completion< detail::sync_wait_event >(t);
+        waiter.start(event);
+        event.wait();
+        return t.result();
+    }
+
+} // namespace sc
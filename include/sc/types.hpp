@@ -18,15 +18,19 @@
 
 #include <llvm/IR/Type.h>
 #include <llvm/IR/DataLayout.h>
+#include <llvm/IR/DerivedTypes.h>
 
 #include <sc/ir.hpp>
 
+#include <vector>
+
 namespace sc
 {
     using type     = llvm::Type *;
     using value    = llvm::Value *;
     using int_type = llvm::IntegerType *;
     using ptr_type = llvm::PointerType *;
+    using vec_type = llvm::FixedVectorType *;
     using data_layout_t = llvm::DataLayout;
 
     type void_t();
@@ -48,10 +52,19 @@ namespace sc
     ptr_type i32p ( unsigned as = 0 );
     ptr_type i64p ( unsigned as = 0 );
 
+    vec_type vec( type element, unsigned n );
+
     unsigned bits ( type ty, const data_layout_t &dl );
     unsigned bytes( type ty, const data_layout_t &dl );
     
     unsigned bits ( value v );
     unsigned bytes( value v );
 
+    // type reached by indexing an aggregate by a path of field indices
+    type field_type( type ty, const std::vector< unsigned > &path );
+
+    // byte offset of a field path in an aggregate, struct layouts are
+    // computed once and cached by the data layout
+    uint64_t offset( type ty, const std::vector< unsigned > &path, const data_layout_t &dl );
+
 } // namespace sc
@@ -14,22 +14,64 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
-#include <numeric>
 #include <sc/annotation.hpp>
 
+#include <llvm/ADT/StringMap.h>
+
+#include <deque>
+#include <mutex>
+
 namespace sc
 {
+    namespace
+    {
+        struct part_pool
+        {
+            std::mutex mutex;
+            llvm::StringMap< annotation::part_id > ids;
+            std::deque< std::string > spellings; // stable references
+        };
+
+        part_pool &pool()
+        {
+            static part_pool parts;
+            return parts;
+        }
+
+    } // anonymous namespace
+
+    annotation::part_id annotation::intern( llvm::StringRef part )
+    {
+        auto &p = pool();
+        std::lock_guard lock( p.mutex );
+
+        auto [ it, inserted ] = p.ids.try_emplace( part, part_id( p.spellings.size() ) );
+        if ( inserted )
+            p.spellings.emplace_back( part );
+        return it->second;
+    }
+
+    const std::string &annotation::spelling( part_id id )
+    {
+        auto &p = pool();
+        std::lock_guard lock( p.mutex );
+        return p.spellings[ id ];
+    }
+
     const std::string &annotation::back() const
     {
-        return _parts.back();
+        return spelling( _parts.back() );
     }
 
     std::string annotation::str() const
     {
-        auto delim = []( const auto &a, const auto &b ) {
-            return a + ( a.length() > 0 ? "." : "" ) + b;
-        };
-        return std::accumulate( _parts.begin(), _parts.end(), std::string(), delim );
+        std::string res;
+        for ( auto id : _parts ) {
+            if ( !res.empty() )
+                res += '.';
+            res += spelling( id );
+        }
+        return res;
     }
 
     size_t annotation::size() const
@@ -39,7 +81,7 @@ namespace sc
 
     std::string_view annotation::name() const
     {
-        return _parts.back();
+        return spelling( _parts.back() );
     }
 
     annotation annotation::get_namespace() const
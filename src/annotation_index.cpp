@@ -0,0 +1,109 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/annotation_index.hpp>
+
+#include <llvm/IR/Constants.h>
+
+#include <atomic>
+
+namespace sc
+{
+    namespace
+    {
+        std::atomic< std::uint64_t > current_generation = 0;
+
+    } // anonymous namespace
+
+    void annotation_index::changed()
+    {
+        current_generation.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    void annotation_index::update()
+    {
+        auto annos = module.getNamedGlobal( "llvm.global.annotations" );
+        auto init = annos && annos->hasInitializer() ? annos->getInitializer() : nullptr;
+        auto gen = current_generation.load( std::memory_order_relaxed );
+
+        if ( root && init == initializer && gen == generation )
+            return;
+
+        initializer = init;
+        generation = gen;
+        root = std::make_unique< node >();
+        entries.clear();
+
+        auto arr = llvm::dyn_cast_or_null< llvm::ConstantArray >( init );
+        if ( !arr )
+            return;
+
+        for ( const auto &op : arr->operands() ) {
+            auto cs = llvm::dyn_cast< llvm::ConstantStruct >( op.get() );
+            if ( !cs || cs->getNumOperands() < 2 )
+                continue;
+
+            auto val = llvm::dyn_cast< llvm::GlobalValue >( cs->getOperand( 0 )->stripPointerCasts() );
+            auto str = llvm::dyn_cast< llvm::GlobalVariable >( cs->getOperand( 1 )->stripPointerCasts() );
+            if ( !val || !str || !str->hasInitializer() )
+                continue;
+
+            if ( auto data = llvm::dyn_cast< llvm::ConstantDataArray >( str->getInitializer() ) )
+                insert( val, annotation( data->getAsCString() ) );
+        }
+    }
+
+    void annotation_index::insert( llvm::GlobalValue *val, annotation ann )
+    {
+        auto n = root.get();
+        for ( const auto &part : ann._parts ) {
+            auto &child = n->children[ part ];
+            if ( !child )
+                child = std::make_unique< node >();
+            n = child.get();
+        }
+
+        auto idx = entries.size();
+        entries.push_back( { val, std::move( ann ) } );
+
+        n->values.push_back( idx );
+        if ( llvm::isa< llvm::Function >( val ) )
+            n->functions.push_back( idx );
+        if ( llvm::isa< llvm::GlobalVariable >( val ) )
+            n->variables.push_back( idx );
+    }
+
+    auto annotation_index::lookup( const annotation &ann ) -> const node *
+    {
+        update();
+
+        const node *n = root.get();
+        for ( const auto &part : ann._parts ) {
+            auto it = n->children.find( part );
+            if ( it == n->children.end() )
+                return nullptr;
+            n = it->second.get();
+        }
+        return n;
+    }
+
+    std::size_t annotation_index::size()
+    {
+        update();
+        return entries.size();
+    }
+
+} // namespace sc
@@ -0,0 +1,135 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/annotation_index.hpp>
+#include <sc/annotation_writer.hpp>
+
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/GlobalVariable.h>
+
+namespace sc
+{
+    namespace
+    {
+        constexpr llvm::StringLiteral annotations = "llvm.global.annotations";
+        constexpr llvm::StringLiteral section = "llvm.metadata";
+
+    } // anonymous namespace
+
+    void annotation_writer::add( llvm::GlobalValue *val, const annotation &ann,
+                                 llvm::StringRef file, unsigned line )
+    {
+        entries.push_back( { val, ann.str(), file.str(), line } );
+    }
+
+    llvm::Constant *annotation_writer::string( llvm::StringRef str )
+    {
+        auto [ it, inserted ] = strings.try_emplace( str, nullptr );
+        if ( !inserted )
+            return it->second;
+
+        auto &ctx = module.getContext();
+        auto data = llvm::ConstantDataArray::getString( ctx, str );
+        auto gv = new llvm::GlobalVariable( module, data->getType(), true,
+            llvm::GlobalValue::PrivateLinkage, data, ".str" );
+        gv->setUnnamedAddr( llvm::GlobalValue::UnnamedAddr::Global );
+        gv->setSection( section );
+
+        auto zero = llvm::ConstantInt::get( llvm::Type::getInt32Ty( ctx ), 0 );
+        llvm::Constant *idxs[] = { zero, zero };
+        it->second = llvm::ConstantExpr::getInBoundsGetElementPtr( data->getType(), gv, idxs );
+        return it->second;
+    }
+
+    void annotation_writer::seed( llvm::ConstantArray *existing )
+    {
+        for ( const auto &op : existing->operands() ) {
+            auto cs = llvm::dyn_cast< llvm::ConstantStruct >( op.get() );
+            if ( !cs )
+                continue;
+
+            // annotation and file name strings
+            for ( unsigned idx : { 1u, 2u } ) {
+                if ( idx >= cs->getNumOperands() )
+                    continue;
+                auto ptr = cs->getOperand( idx );
+                auto gv = llvm::dyn_cast< llvm::GlobalVariable >( ptr->stripPointerCasts() );
+                if ( !gv || !gv->hasInitializer() )
+                    continue;
+                if ( auto data = llvm::dyn_cast< llvm::ConstantDataArray >( gv->getInitializer() ) ) {
+                    if ( data->isCString() )
+                        strings.try_emplace( data->getAsCString(), ptr );
+                }
+            }
+        }
+    }
+
+    void annotation_writer::finalize()
+    {
+        if ( entries.empty() )
+            return;
+
+        auto &ctx = module.getContext();
+        auto i8p = llvm::Type::getInt8PtrTy( ctx );
+        auto i32 = llvm::Type::getInt32Ty( ctx );
+
+        auto old = module.getNamedGlobal( annotations );
+        auto existing = old && old->hasInitializer()
+            ? llvm::dyn_cast< llvm::ConstantArray >( old->getInitializer() ) : nullptr;
+
+        // follow the layout of present entries, older producers omit the
+        // trailing arguments pointer
+        auto entry_type = existing
+            ? llvm::cast< llvm::StructType >( existing->getType()->getElementType() )
+            : llvm::StructType::get( ctx, { i8p, i8p, i8p, i32, i8p } );
+
+        std::vector< llvm::Constant * > elements;
+        elements.reserve( ( existing ? existing->getNumOperands() : 0 ) + entries.size() );
+
+        if ( existing ) {
+            seed( existing );
+            for ( const auto &op : existing->operands() )
+                elements.push_back( llvm::cast< llvm::Constant >( op.get() ) );
+        }
+
+        auto null = llvm::ConstantPointerNull::get( i8p );
+        for ( const auto &e : entries ) {
+            llvm::Constant *fields[] = {
+                llvm::ConstantExpr::getPointerBitCastOrAddrSpaceCast( e.val, i8p ),
+                string( e.ann ),
+                e.file.empty() ? null : string( e.file ),
+                llvm::ConstantInt::get( i32, e.line ),
+                null
+            };
+            elements.push_back( llvm::ConstantStruct::get(
+                entry_type, llvm::makeArrayRef( fields, entry_type->getNumElements() )
+            ) );
+        }
+        entries.clear();
+
+        auto array_type = llvm::ArrayType::get( entry_type, elements.size() );
+        auto gv = new llvm::GlobalVariable( module, array_type, false,
+            llvm::GlobalValue::AppendingLinkage, llvm::ConstantArray::get( array_type, elements ) );
+        gv->setSection( section );
+
+        if ( old )
+            old->eraseFromParent();
+        gv->setName( annotations );
+
+        annotation_index::changed();
+    }
+
+} // namespace sc
@@ -0,0 +1,129 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/codegen.hpp>
+#include <sc/warnings.hpp>
+
+SC_RELAX_WARNINGS
+// ahead of the bitcode headers, which would pull it in with the warning on;
+// GCC 12 flags a null dereference in ErrorList::join defined there
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnull-dereference"
+#include <llvm/Support/Error.h>
+#pragma GCC diagnostic pop
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+SC_UNRELAX_WARNINGS
+
+#include <stdexcept>
+
+namespace sc
+{
+    namespace
+    {
+        object_code compile( const object_code &bitcode, opt_level level )
+        {
+            llvm::LLVMContext ctx;
+
+            auto buffer = llvm::MemoryBufferRef( { bitcode.data(), bitcode.size() }, "partition" );
+            auto parsed = llvm::parseBitcodeFile( buffer, ctx );
+            if ( !parsed )
+                throw std::runtime_error( llvm::toString( parsed.takeError() ) );
+
+            auto &m = **parsed;
+            auto tm = native_target_machine( level );
+            m.setDataLayout( tm->createDataLayout() );
+            m.setTargetTriple( tm->getTargetTriple().str() );
+
+            if ( level != opt_level::none )
+                optimize( m, level );
+
+            object_code obj;
+            llvm::raw_svector_ostream os( obj );
+
+            llvm::legacy::PassManager pm;
+            if ( tm->addPassesToEmitFile( pm, os, nullptr, llvm::CGFT_ObjectFile ) )
+                throw std::runtime_error( "target can not emit object files" );
+            pm.run( m );
+
+            return obj;
+        }
+
+    } // anonymous namespace
+
+    std::vector< object_code > codegen::emit( const llvm::Module &m, unsigned partitions ) const
+    {
+        init_native_target();
+
+        // splitting externalizes local symbols, work on a copy
+        auto copy = llvm::CloneModule( m );
+
+        std::vector< object_code > bitcode;
+        llvm::SplitModule( *copy, partitions, [ &bitcode ] ( std::unique_ptr< llvm::Module > part ) {
+            llvm::raw_svector_ostream os( bitcode.emplace_back() );
+            llvm::WriteBitcodeToFile( *part, os );
+        } );
+
+        std::vector< object_code > objects( bitcode.size() );
+
+        llvm::ThreadPool pool( llvm::hardware_concurrency( threads ) );
+        std::vector< std::shared_future< void > > tasks;
+        for ( std::size_t idx = 0; idx < bitcode.size(); ++idx ) {
+            tasks.push_back( pool.async( [ &, idx ] {
+                objects[ idx ] = compile( bitcode[ idx ], level );
+            } ) );
+        }
+
+        // rethrows failures of workers
+        for ( auto &task : tasks )
+            task.get();
+
+        return objects;
+    }
+
+    std::vector< std::string > codegen::write( const llvm::Module &m, unsigned partitions,
+                                               const std::string &prefix ) const
+    {
+        std::vector< std::string > paths;
+
+        auto objects = emit( m, partitions );
+        for ( std::size_t idx = 0; idx < objects.size(); ++idx ) {
+            auto &path = paths.emplace_back( prefix + "." + std::to_string( idx ) + ".o" );
+
+            std::error_code ec;
+            llvm::raw_fd_ostream os( path, ec, llvm::sys::fs::OF_None );
+            if ( ec )
+                throw std::runtime_error( path + ": " + ec.message() );
+            os.write( objects[ idx ].data(), objects[ idx ].size() );
+            os.close();
+            if ( os.has_error() ) {
+                auto err = os.error();
+                os.clear_error();
+                throw std::runtime_error( path + ": " + err.message() );
+            }
+        }
+
+        return paths;
+    }
+
+} // namespace sc
@@ -0,0 +1,71 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/erase.hpp>
+
+SC_RELAX_WARNINGS
+#include <llvm/IR/Constants.h>
+SC_UNRELAX_WARNINGS
+
+namespace sc
+{
+    bool batch_eraser::push(instruction inst)
+    {
+        if (!seen.insert(inst).second) {
+            ++duplicates;
+            return false;
+        }
+
+        dead.push_back(inst);
+        return true;
+    }
+
+    erase_stats batch_eraser::erase()
+    {
+        erase_stats batch;
+        batch.duplicates = duplicates;
+
+        // uses among the dead instructions disappear with their operands
+        for (auto inst : dead)
+            inst->dropAllReferences();
+
+        for (auto inst : dead) {
+            if (!inst->use_empty()) {
+                batch.replaced_uses += inst->getNumUses();
+                inst->replaceAllUsesWith(llvm::UndefValue::get(inst->getType()));
+            }
+        }
+
+        for (auto inst : dead) {
+            if (inst->getParent())
+                inst->eraseFromParent();
+            else
+                inst->deleteValue();
+        }
+
+        batch.erased = dead.size();
+
+        total.erased += batch.erased;
+        total.duplicates += batch.duplicates;
+        total.replaced_uses += batch.replaced_uses;
+
+        seen.clear();
+        dead.clear();
+        duplicates = 0;
+        return batch;
+    }
+
+} // namespace sc
@@ -15,12 +15,16 @@
  */
 
 #include <sc/init.hpp>
+#include <sc/meta.hpp>
+
 namespace sc
 {
     extern context_t * _context;
 
     void init( context_ref ctx )
     {
+        // the context may reuse the address of a destroyed one
+        meta::reset( ctx );
         _context = &ctx;
     }
 
@@ -0,0 +1,155 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/jit.hpp>
+
+SC_RELAX_WARNINGS
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/raw_ostream.h>
+SC_UNRELAX_WARNINGS
+
+#include <stdexcept>
+
+namespace sc
+{
+    namespace
+    {
+        template< typename T >
+        T unwrap( llvm::Expected< T > &&v )
+        {
+            if ( !v )
+                throw std::runtime_error( llvm::toString( v.takeError() ) );
+            return std::move( *v );
+        }
+
+        void check( llvm::Error err )
+        {
+            if ( err )
+                throw std::runtime_error( llvm::toString( std::move( err ) ) );
+        }
+
+    } // anonymous namespace
+
+    object_cache::key_t object_cache::hash( const llvm::Module *m )
+    {
+        llvm::SmallVector< char, 0 > buffer;
+        llvm::raw_svector_ostream os( buffer );
+        llvm::WriteBitcodeToFile( *m, os );
+
+        llvm::MD5 md5;
+        llvm::MD5::MD5Result result;
+        md5.update( os.str() );
+        md5.final( result );
+        return result.words();
+    }
+
+    std::unique_ptr< llvm::MemoryBuffer > object_cache::getObject( const llvm::Module *m )
+    {
+        auto key = hash( m );
+
+        std::lock_guard lock( mutex );
+        if ( auto it = objects.find( key ); it != objects.end() ) {
+            ++hit_count;
+            return llvm::MemoryBuffer::getMemBufferCopy(
+                it->second->getBuffer(), it->second->getBufferIdentifier()
+            );
+        }
+
+        pending[ m ] = key;
+        return nullptr;
+    }
+
+    void object_cache::notifyObjectCompiled( const llvm::Module *m, llvm::MemoryBufferRef obj )
+    {
+        std::lock_guard lock( mutex );
+        auto it = pending.find( m );
+        if ( it == pending.end() )
+            return;
+
+        objects[ it->second ] = llvm::MemoryBuffer::getMemBufferCopy(
+            obj.getBuffer(), obj.getBufferIdentifier()
+        );
+        pending.erase( it );
+    }
+
+    std::size_t object_cache::size() const
+    {
+        std::lock_guard lock( mutex );
+        return objects.size();
+    }
+
+    std::size_t object_cache::hits() const
+    {
+        std::lock_guard lock( mutex );
+        return hit_count;
+    }
+
+    jit::jit( opt_level level, std::shared_ptr< object_cache > cache )
+        : objects( cache ? std::move( cache ) : std::make_shared< object_cache >() )
+    {
+        init_native_target();
+
+        auto create_compiler = [ objs = objects.get() ] ( llvm::orc::JITTargetMachineBuilder jtmb )
+            -> llvm::Expected< std::unique_ptr< llvm::orc::IRCompileLayer::IRCompiler > >
+        {
+            return std::make_unique< llvm::orc::ConcurrentIRCompiler >( std::move( jtmb ), objs );
+        };
+
+        engine = unwrap( llvm::orc::LLLazyJITBuilder()
+            .setCompileFunctionCreator( std::move( create_compiler ) )
+            .create()
+        );
+
+        if ( level != opt_level::none ) {
+            engine->getIRTransformLayer().setTransform(
+                [ level ] ( llvm::orc::ThreadSafeModule tsm, const auto & ) {
+                    tsm.withModuleDo( [ level ] ( llvm::Module &m ) { optimize( m, level ); } );
+                    return llvm::Expected< llvm::orc::ThreadSafeModule >( std::move( tsm ) );
+                }
+            );
+        }
+    }
+
+    jit::~jit() = default;
+
+    void jit::add( const llvm::Module &m )
+    {
+        // copy the module through bitcode, contexts can not share modules
+        llvm::SmallVector< char, 0 > buffer;
+        llvm::raw_svector_ostream os( buffer );
+        llvm::WriteBitcodeToFile( m, os );
+
+        auto ctx = std::make_unique< llvm::LLVMContext >();
+        auto ref = llvm::MemoryBufferRef( os.str(), m.getModuleIdentifier() );
+        auto copy = unwrap( llvm::parseBitcodeFile( ref, *ctx ) );
+
+        if ( copy->getDataLayout().isDefault() )
+            copy->setDataLayout( engine->getDataLayout() );
+
+        auto tsm = llvm::orc::ThreadSafeModule( std::move( copy ), std::move( ctx ) );
+        check( engine->addLazyIRModule( std::move( tsm ) ) );
+    }
+
+    std::uint64_t jit::address( const std::string &name )
+    {
+        return unwrap( engine->lookup( name ) ).getAddress();
+    }
+
+} // namespace sc
@@ -14,7 +14,9 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <llvm/ADT/StringMap.h>
 #include <llvm/IR/Argument.h>
+#include <llvm/IR/Constants.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/Instruction.h>
@@ -22,6 +24,9 @@
 #include <sc/context.hpp>
 #include <sc/transformer.hpp>
 #include <sc/meta.hpp>
+#include <sc/meta_index.hpp>
+
+#include <map>
 
 namespace sc::meta
 {
@@ -29,28 +34,60 @@ namespace sc::meta
     {
         void arg_set( llvm::Argument *, meta_str ) {}
 
+        using uniqued_cache = llvm::StringMap< llvm::MDTuple * >;
+
+        std::map< context_t *, uniqued_cache > &caches()
+        {
+            static std::map< context_t *, uniqued_cache > cache;
+            return cache;
+        }
+
         template< typename T > 
-        void set( T *val, tag_t tag, meta_str meta )
+        void set( T *val, tag_t tag, meta_str meta, mode m )
         {
-            if constexpr ( std::is_same_v< T, llvm::Argument > )
+            if constexpr ( std::is_same_v< T, llvm::Argument > ) {
                 argument::set( val, meta );
-            else
-                val->setMetadata( tag, tuple::create( node( meta ) ) );
+            } else {
+                auto data = m == mode::uniqued ? tuple::uniqued( meta ) : tuple::create( node( meta ) );
+                val->setMetadata( tag, data );
+                index::notify( val, tag, llvm::cast< llvm::MDNode >( data->getOperand( 0 ) ) );
+            }
+        }
+
+        template< typename T >
+        void set( T *val, tag_t tag, node_t payload, mode m )
+        {
+            if constexpr ( std::is_same_v< T, llvm::Argument > ) {
+                argument::set( val, payload );
+            } else {
+                if ( m == mode::uniqued )
+                    val->setMetadata( tag, llvm::MDTuple::get( context(), payload ) );
+                else
+                    val->setMetadata( tag, tuple::create( payload ) );
+                index::notify( val, tag, payload );
+            }
+        }
+
+        node_t payload( node_t node, unsigned idx = 0 )
+        {
+            if ( !node )
+                return nullptr;
+
+            assert( node->getNumOperands() );
+            return llvm::cast< llvm::MDNode >( node->getOperand( idx ) );
         }
 
         maybe_meta_str value( node_t node, unsigned idx = 0 )
         {
             if ( !node )
                 return std::nullopt;
+            return get_string( payload( node, idx ) );
+        }
 
-            assert( node->getNumOperands() );
-            
-            auto & op = node->getOperand( idx );
-            auto str = llvm::cast< llvm::MDString >( llvm::cast< llvm::MDNode >( op )->getOperand( 0 ) );
-            
-            if (auto res = str->getString().str(); !res.empty() )
-                return res;
-            return std::nullopt;
+        node_t argument_payload( llvm::Argument *arg )
+        {
+            auto fn = arg->getParent();
+            return payload( fn->getMetadata( tag::arguments ), arg->getArgNo() );
         }
 
         template< typename T > 
@@ -62,16 +99,13 @@ namespace sc::meta
                 return value( val->getMetadata( tag ) );
         }
 
-        void function_init( llvm::Function *fn )
+        template< typename T >
+        node_t get_node( T *val, tag_t tag )
         {
-            auto size = fn->arg_size();
-
-            if ( !fn->getMetadata( tag::arguments ) ) 
-            {
-                auto value = [ & ] { return node( tag::none ); };
-                auto *data = tuple::create( size, value );
-                fn->setMetadata( tag::arguments, data );
-            }
+            if constexpr ( std::is_same_v< T, llvm::Argument > )
+                return argument_payload( val );
+            else
+                return payload( val->getMetadata( tag ) );
         }
 
     } // namespace detail
@@ -82,14 +116,66 @@ namespace sc::meta
         return llvm::MDNode::get( ctx, llvm::MDString::get( ctx, str ) );
     }
 
+    llvm::MDTuple *tuple::uniqued( meta_str str )
+    {
+        auto &cache = detail::caches()[ context_ptr() ];
+        auto [ it, inserted ] = cache.try_emplace( str, nullptr );
+        if ( inserted )
+            it->second = llvm::MDTuple::get( context(), node( str ) );
+        return it->second;
+    }
+
+    void reset( context_ref ctx )
+    {
+        detail::caches().erase( &ctx );
+    }
+
+    node_t node( llvm::Constant *c )
+    {
+        return llvm::MDNode::get( context(), llvm::ConstantAsMetadata::get( c ) );
+    }
+
+    bool custom_kind( unsigned kind )
+    {
+        // kinds registered by llvm itself precede all custom kinds
+        constexpr unsigned fixed = 0
+        #define LLVM_FIXED_MD_KIND( id, name, value ) + 1
+        #include <llvm/IR/FixedMetadataKinds.def>
+        #undef LLVM_FIXED_MD_KIND
+        ;
+        return kind >= fixed;
+    }
+
+    node_t attached_payload( llvm::MDNode *attachment )
+    {
+        if ( attachment->getNumOperands() != 1 )
+            return nullptr;
+        auto n = llvm::dyn_cast< llvm::MDNode >( attachment->getOperand( 0 ) );
+        if ( !n || !n->getNumOperands() )
+            return nullptr;
+        auto &op = n->getOperand( 0 );
+        if ( op && ( llvm::isa< llvm::MDString >( op ) || llvm::isa< llvm::ConstantAsMetadata >( op ) ) )
+            return n;
+        return nullptr;
+    }
+
     maybe_meta_str get_string( node_t n )
     {
         if ( !n || !n->getNumOperands() ) return std::nullopt;
 
-        const auto &str = n->getOperand( 0 );
-        auto res        = llvm::cast< llvm::MDString >( str )->getString().str();
-        if ( res.empty() ) return std::nullopt;
-        return res;
+        // view into the uniqued string owned by the context
+        auto str = llvm::dyn_cast< llvm::MDString >( n->getOperand( 0 ) );
+        if ( !str || str->getString().empty() ) return std::nullopt;
+        return str->getString();
+    }
+
+    llvm::Constant *get_constant( node_t n )
+    {
+        if ( !n || !n->getNumOperands() ) return nullptr;
+
+        if ( auto c = llvm::dyn_cast< llvm::ConstantAsMetadata >( n->getOperand( 0 ) ) )
+            return c->getValue();
+        return nullptr;
     }
 
     void argument::set( llvm::Argument *arg, meta_str str )
@@ -99,11 +185,67 @@ namespace sc::meta
 
     void argument::set( llvm::Argument *arg, node_t node )
     {
-        auto fn = arg->getParent();
-        detail::function_init( fn );
+        llvm::SmallVector< node_t, 8 > nodes( arg->getArgNo() + 1, nullptr );
+        nodes.back() = node;
+        set_all( arg->getParent(), nodes );
+    }
+
+    void argument::set_all( llvm::Function *fn, std::span< const meta_str > strs )
+    {
+        std::vector< node_t > nodes;
+        nodes.reserve( strs.size() );
+        for ( auto str : strs )
+            nodes.push_back( meta::node( str ) );
+        set_all( fn, nodes );
+    }
+
+    void argument::set_all( llvm::Function *fn, llvm::ArrayRef< node_t > nodes )
+    {
+        assert( nodes.size() <= fn->arg_size() );
+
+        // null nodes leave the argument untouched
+        if ( auto meta = fn->getMetadata( tag::arguments ) ) {
+            for ( unsigned idx = 0; idx < nodes.size(); ++idx ) {
+                if ( nodes[ idx ] && meta->getOperand( idx ) != nodes[ idx ] )
+                    meta->replaceOperandWith( idx, nodes[ idx ] );
+            }
+        } else if ( fn->arg_size() ) {
+            node_t none = meta::node( tag::none );
+            std::vector< llvm::Metadata * > ops( fn->arg_size(), none );
+            for ( unsigned idx = 0; idx < nodes.size(); ++idx ) {
+                if ( nodes[ idx ] )
+                    ops[ idx ] = nodes[ idx ];
+            }
+            fn->setMetadata( tag::arguments, tuple::create( ops ) );
+        }
+
+        for ( unsigned idx = 0; idx < nodes.size(); ++idx ) {
+            if ( nodes[ idx ] )
+                index::notify( fn->getArg( idx ), tag::arguments, nodes[ idx ] );
+        }
+    }
 
-        auto meta = fn->getMetadata( tag::arguments );
-        meta->replaceOperandWith( arg->getArgNo(), node );
+    void argument::batch::set( llvm::Argument *arg, meta_str str )
+    {
+        auto [ it, inserted ] = nodes.try_emplace( str, nullptr );
+        if ( inserted )
+            it->second = meta::node( str );
+        set( arg, it->second );
+    }
+
+    void argument::batch::set( llvm::Argument *arg, node_t node )
+    {
+        auto &args = functions[ arg->getParent() ];
+        if ( args.size() <= arg->getArgNo() )
+            args.resize( arg->getArgNo() + 1, nullptr );
+        args[ arg->getArgNo() ] = node;
+    }
+
+    void argument::batch::commit()
+    {
+        for ( auto &[ fn, args ] : functions )
+            set_all( fn, args );
+        functions.clear();
     }
 
     maybe_meta_str argument::get( llvm::Argument *arg )
@@ -114,15 +256,39 @@ namespace sc::meta
         return std::nullopt;
     }
 
-    void set( llvm::Value *v, tag_t t, meta_str m )
+    void set( llvm::Value *v, tag_t t, meta_str m, mode md )
     {
         sc::llvmcase(
             v,
-            [ & ]( llvm::Argument *a ) { detail::set( a, t, m ); },
-            [ & ]( llvm::Instruction *i ) { detail::set( i, t, m ); },
-            [ & ]( llvm::GlobalVariable *g ) { detail::set( g, t, m ); },
-            [ & ]( llvm::Function *f ) { detail::set( f, t, m ); },
+            [ & ]( llvm::Argument *a ) { detail::set( a, t, m, md ); },
+            [ & ]( llvm::Instruction *i ) { detail::set( i, t, m, md ); },
+            [ & ]( llvm::GlobalVariable *g ) { detail::set( g, t, m, md ); },
+            [ & ]( llvm::Function *f ) { detail::set( f, t, m, md ); },
+            [ & ]( llvm::Value * ) { __builtin_unreachable(); } );
+    }
+
+    void set_node( llvm::Value *v, tag_t t, node_t payload, mode md )
+    {
+        sc::llvmcase(
+            v,
+            [ & ]( llvm::Argument *a ) { detail::set( a, t, payload, md ); },
+            [ & ]( llvm::Instruction *i ) { detail::set( i, t, payload, md ); },
+            [ & ]( llvm::GlobalVariable *g ) { detail::set( g, t, payload, md ); },
+            [ & ]( llvm::Function *f ) { detail::set( f, t, payload, md ); },
+            [ & ]( llvm::Value * ) { __builtin_unreachable(); } );
+    }
+
+    node_t get_node( llvm::Value *val, tag_t tag )
+    {
+        node_t n = nullptr;
+        sc::llvmcase(
+            val,
+            [ & ]( llvm::Argument *a ) { n = detail::get_node( a, tag ); },
+            [ & ]( llvm::Instruction *i ) { n = detail::get_node( i, tag ); },
+            [ & ]( llvm::GlobalVariable *g ) { n = detail::get_node( g, tag ); },
+            [ & ]( llvm::Function *f ) { n = detail::get_node( f, tag ); },
             [ & ]( llvm::Value * ) { __builtin_unreachable(); } );
+        return n;
     }
 
     maybe_meta_str get( llvm::Value *val, tag_t tag )
@@ -0,0 +1,240 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/meta_index.hpp>
+
+#include <llvm/IR/Argument.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instruction.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace sc::meta
+{
+    namespace
+    {
+        // live indices of all modules, modules of distinct contexts may be
+        // tagged from distinct threads
+        std::map< const llvm::Module *, std::set< index * > > &registry()
+        {
+            static std::map< const llvm::Module *, std::set< index * > > live;
+            return live;
+        }
+
+        std::mutex registry_mutex;
+
+        // lets notify skip the lock while no index exists
+        std::atomic< std::size_t > registry_size = 0;
+
+        // null for values not (yet) placed in a module
+        const llvm::Module *parent( llvm::Value *val )
+        {
+            if ( auto arg = llvm::dyn_cast< llvm::Argument >( val ) )
+                return arg->getParent()->getParent();
+            if ( auto inst = llvm::dyn_cast< llvm::Instruction >( val ) ) {
+                auto bb = inst->getParent();
+                return bb && bb->getParent() ? bb->getModule() : nullptr;
+            }
+            if ( auto gv = llvm::dyn_cast< llvm::GlobalValue >( val ) )
+                return gv->getParent();
+            return nullptr;
+        }
+
+        bool unset( node_t payload )
+        {
+            auto str = get_string( payload );
+            return str && str.value() == tag::none;
+        }
+
+    } // anonymous namespace
+
+    void index::bucket::insert( llvm::Value *val )
+    {
+        auto [ it, inserted ] = position.try_emplace( val, entries.size() );
+        if ( inserted )
+            entries.push_back( { val, val } );
+        else // the address may belong to an erased value
+            entries[ it->second ].handle = val;
+    }
+
+    void index::bucket::erase( std::size_t pos )
+    {
+        position.erase( entries[ pos ].key );
+        if ( pos != entries.size() - 1 ) {
+            entries[ pos ] = entries.back();
+            position[ entries[ pos ].key ] = pos;
+        }
+        entries.pop_back();
+    }
+
+    index::index( llvm::Module &m ) : module( m )
+    {
+        std::lock_guard lock( registry_mutex );
+        registry()[ &module ].insert( this );
+        ++registry_size;
+    }
+
+    index::~index()
+    {
+        std::lock_guard lock( registry_mutex );
+        auto &live = registry();
+        auto it = live.find( &module );
+        it->second.erase( this );
+        if ( it->second.empty() )
+            live.erase( it );
+        --registry_size;
+    }
+
+    void index::notify( llvm::Value *val, tag_t tag, node_t payload )
+    {
+        if ( registry_size == 0 )
+            return;
+
+        // detached values are found by the next rescan
+        auto m = parent( val );
+        if ( !m )
+            return;
+
+        std::lock_guard lock( registry_mutex );
+        auto &live = registry();
+        if ( auto it = live.find( m ); it != live.end() ) {
+            for ( auto idx : it->second ) {
+                if ( !idx->stale )
+                    idx->insert( val, tag, payload );
+            }
+        }
+    }
+
+    void index::insert( llvm::Value *val, tag_t tag, node_t payload )
+    {
+        if ( tag == tag::arguments && unset( payload ) )
+            return;
+        tags[ tag ].insert( val );
+        payloads[ tag ][ payload ].insert( val );
+    }
+
+    void index::invalidate()
+    {
+        stale = true;
+    }
+
+    // GCC reports potential null dereferences in the inlined ilist and
+    // TrackingMDRef accessors of the module walk
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnull-dereference"
+    void index::rebuild()
+    {
+        tags.clear();
+        payloads.clear();
+        stale = false;
+
+        llvm::SmallVector< std::pair< unsigned, llvm::MDNode * >, 4 > attached;
+        llvm::SmallVector< llvm::StringRef, 16 > names;
+        module.getContext().getMDKindNames( names );
+
+        auto scan = [ & ] ( auto *val ) {
+            attached.clear();
+            val->getAllMetadata( attached );
+            for ( auto [ kind, tuple ] : attached ) {
+                if ( !custom_kind( kind ) || names[ kind ] == tag::arguments )
+                    continue;
+                if ( auto node = attached_payload( tuple ) )
+                    insert( val, names[ kind ], node );
+            }
+        };
+
+        for ( auto &gv : module.globals() )
+            scan( &gv );
+
+        for ( auto &fn : module ) {
+            scan( &fn );
+
+            if ( auto args = fn.getMetadata( tag::arguments ) ) {
+                for ( auto &arg : fn.args() ) {
+                    auto payload = llvm::cast< llvm::MDNode >( args->getOperand( arg.getArgNo() ) );
+                    insert( &arg, tag::arguments, payload );
+                }
+            }
+
+            for ( auto &bb : fn )
+                for ( auto &inst : bb )
+                    scan( &inst );
+        }
+    }
+#pragma GCC diagnostic pop
+
+    template< typename valid_t >
+    std::vector< llvm::Value * > index::collect( bucket &b, valid_t valid )
+    {
+        std::vector< llvm::Value * > result;
+        result.reserve( b.entries.size() );
+
+        for ( std::size_t pos = 0; pos < b.entries.size(); ) {
+            llvm::Value *val = b.entries[ pos ].handle;
+            if ( val && valid( val ) ) {
+                result.push_back( val );
+                ++pos;
+            } else {
+                b.erase( pos );
+            }
+        }
+
+        return result;
+    }
+
+    std::vector< llvm::Value * > index::values( tag_t tag )
+    {
+        if ( stale )
+            rebuild();
+
+        auto it = tags.find( tag );
+        if ( it == tags.end() )
+            return {};
+
+        return collect( it->second, [ & ] ( llvm::Value *val ) {
+            auto payload = get_node( val, tag );
+            return payload && !( tag == tag::arguments && unset( payload ) );
+        } );
+    }
+
+    std::vector< llvm::Value * > index::values( tag_t tag, meta_str payload )
+    {
+        return values( tag, node( payload ) );
+    }
+
+    std::vector< llvm::Value * > index::values( tag_t tag, node_t payload )
+    {
+        if ( stale )
+            rebuild();
+
+        auto it = payloads.find( tag );
+        if ( it == payloads.end() )
+            return {};
+
+        auto bt = it->second.find( payload );
+        if ( bt == it->second.end() )
+            return {};
+
+        return collect( bt->second, [ & ] ( llvm::Value *val ) {
+            return get_node( val, tag ) == payload;
+        } );
+    }
+
+} // namespace sc::meta
@@ -0,0 +1,73 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/numbering.hpp>
+
+#include <llvm/ADT/Hashing.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Instruction.h>
+
+namespace sc
+{
+    namespace
+    {
+        value operand( const llvm::Instruction *inst, unsigned idx )
+        {
+            return idx < inst->getNumOperands() ? inst->getOperand( idx ) : nullptr;
+        }
+
+        // The table is keyed by operand addresses, which may be reused once
+        // an operand is erased (e.g. a trivial phi replaced on sealing), and
+        // the cached instruction itself may have had its operands replaced.
+        bool computes( const llvm::Instruction *inst, const expression &e )
+        {
+            if ( inst->getOpcode() != e.opcode )
+                return false;
+            if ( auto c = llvm::dyn_cast< llvm::CmpInst >( inst ); c && c->getPredicate() != e.pred )
+                return false;
+            if ( e.ty && inst->getType() != e.ty )
+                return false;
+
+            auto lhs = operand( inst, 0 ), rhs = operand( inst, 1 );
+            if ( lhs == e.lhs && rhs == e.rhs )
+                return true;
+            return inst->isCommutative() && lhs == e.rhs && rhs == e.lhs;
+        }
+
+    } // anonymous namespace
+
+    std::size_t value_numbering::hash::operator()( const key_t &key ) const
+    {
+        const auto &[ bb, e ] = key;
+        return llvm::hash_combine( bb, e.opcode, e.pred, e.ty, e.lhs, e.rhs );
+    }
+
+    value value_numbering::lookup( basicblock bb, const expression &e ) const
+    {
+        auto it = table.find( { bb, e } );
+        if ( it == table.end() || !it->second )
+            return nullptr;
+
+        auto inst = llvm::cast< llvm::Instruction >( it->second );
+        return inst->getParent() == bb && computes( inst, e ) ? inst : nullptr;
+    }
+
+    void value_numbering::insert( basicblock bb, const expression &e, value v )
+    {
+        table.insert_or_assign( { bb, e }, v );
+    }
+
+} // namespace sc
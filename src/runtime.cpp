@@ -0,0 +1,85 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/runtime.hpp>
+
+#include <llvm/IR/Instructions.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace sc
+{
+    runtime_function::runtime_function( llvm::FunctionCallee callee )
+        : fn( callee ), fty( callee.getFunctionType() )
+    {
+        auto params = signature()->params();
+        plan.resize( params.size() );
+        for ( unsigned idx = 0; idx < params.size(); ++idx )
+            plan[ idx ].push_back( { params[ idx ], no_cast } );
+    }
+
+    value runtime_function::coerce( llvm::IRBuilderBase &irb, unsigned idx, value arg ) const
+    {
+        if ( idx >= plan.size() ) // variadic part
+            return arg;
+
+        auto from = arg->getType();
+        auto &seen = plan[ idx ];
+
+        auto it = std::find_if( seen.begin(), seen.end(), [ from ] ( const auto &c ) {
+            return c.from == from;
+        } );
+
+        if ( it == seen.end() ) {
+            auto to = signature()->getParamType( idx );
+            auto op = llvm::CastInst::getCastOpcode( arg, false, to, false );
+            assert( llvm::CastInst::castIsValid( op, from, to ) && "uncoercible runtime argument" );
+            it = seen.insert( seen.end(), { from, op } );
+        }
+
+        if ( it->op == no_cast )
+            return arg;
+        auto op = static_cast< llvm::Instruction::CastOps >( it->op );
+        return irb.CreateCast( op, arg, signature()->getParamType( idx ) );
+    }
+
+    llvm::CallInst * runtime_function::call( llvm::IRBuilderBase &irb, std::span< const value > args ) const
+    {
+        llvm::SmallVector< value, 8 > coerced;
+        coerced.reserve( args.size() );
+
+        unsigned idx = 0;
+        for ( auto arg : args )
+            coerced.push_back( coerce( irb, idx++, arg ) );
+
+        return irb.CreateCall( fn, coerced );
+    }
+
+    const runtime_function& runtime::get( const std::string &name, function_type ty )
+    {
+        auto &entry = functions[ { name, ty } ];
+        if ( !entry )
+            entry = std::make_unique< runtime_function >( module->getOrInsertFunction( name, ty ) );
+        return *entry;
+    }
+
+    const runtime_function& runtime::get( const std::string &name, type ret, const std::vector< type > &args )
+    {
+        return get( name, llvm::FunctionType::get( ret, args, false ) );
+    }
+
+} // namespace sc
@@ -0,0 +1,129 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/scheduler.hpp>
+
+#include <algorithm>
+
+namespace sc
+{
+    namespace
+    {
+        // worker the current thread runs, if any
+        thread_local const scheduler *current_scheduler = nullptr;
+        thread_local std::size_t current_worker = 0;
+
+    } // anonymous namespace
+
+    scheduler::scheduler(unsigned nthreads) {
+        auto count = std::max(nthreads, 1u);
+        for (unsigned i = 0; i < count; ++i) {
+            _workers.push_back(std::make_unique< worker >());
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            _threads.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    scheduler::~scheduler() {
+        {
+            std::lock_guard lock(_sleep_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+
+        for (auto &thread : _threads) {
+            thread.join();
+        }
+    }
+
+    void scheduler::enqueue(sc::coroutine_handle<> h) {
+        auto idx = current_scheduler == this
+                 ? current_worker
+                 : _next.fetch_add(1, std::memory_order_relaxed) % _workers.size();
+
+        // counted ahead of the push so that the count never drops below
+        // the number of queued coroutines
+        _pending.fetch_add(1, std::memory_order_release);
+        {
+            auto &w = *_workers[idx];
+            std::lock_guard lock(w.mutex);
+            w.queue.push_back(h);
+        }
+
+        {
+            // pairs with the predicate check of sleeping workers
+            std::lock_guard lock(_sleep_mutex);
+        }
+        _wake.notify_one();
+    }
+
+    sc::coroutine_handle<> scheduler::pop(std::size_t idx) {
+        auto &w = *_workers[idx];
+        std::lock_guard lock(w.mutex);
+        if (w.queue.empty()) {
+            return nullptr;
+        }
+
+        auto h = w.queue.back();
+        w.queue.pop_back();
+        return h;
+    }
+
+    sc::coroutine_handle<> scheduler::steal(std::size_t idx) {
+        for (std::size_t i = 1; i < _workers.size(); ++i) {
+            auto &victim = *_workers[(idx + i) % _workers.size()];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.queue.empty()) {
+                auto h = victim.queue.front();
+                victim.queue.pop_front();
+                _steals.fetch_add(1, std::memory_order_relaxed);
+                return h;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void scheduler::run(std::size_t idx) {
+        current_scheduler = this;
+        current_worker    = idx;
+
+        while (true) {
+            auto h = pop(idx);
+            if (!h) {
+                h = steal(idx);
+            }
+
+            if (h) {
+                _pending.fetch_sub(1, std::memory_order_acq_rel);
+                h.resume();
+                continue;
+            }
+
+            std::unique_lock lock(_sleep_mutex);
+            _wake.wait(lock, [&] {
+                return _stop || _pending.load(std::memory_order_acquire) > 0;
+            });
+
+            if (_stop && _pending.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+
+} // namespace sc
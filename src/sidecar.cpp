@@ -0,0 +1,354 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/sidecar.hpp>
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+
+namespace sc::meta
+{
+    namespace
+    {
+        constexpr char magic[ 8 ] = { 's', 'c', 'm', 'e', 't', 'a', 0, 1 };
+
+        struct header
+        {
+            char magic[ 8 ];
+            uint64_t entries;
+            uint64_t strings_size;
+        };
+
+        using entry = sidecar::entry;
+
+        constexpr tag_t annotation_tag = "llvm.global.annotations";
+
+        struct writer
+        {
+            explicit writer( llvm::Module &m ) : module( m ) {}
+
+            std::pair< uint32_t, uint32_t > string( llvm::StringRef str )
+            {
+                auto [ it, inserted ] = offsets.try_emplace( str, uint32_t( table.size() ) );
+                if ( inserted )
+                    table.append( str.begin(), str.end() );
+                return { it->second, uint32_t( str.size() ) };
+            }
+
+            void add( llvm::StringRef owner, sidecar::slot_kind kind, uint32_t slot,
+                      tag_t tag, node_t payload )
+            {
+                if ( auto str = get_string( payload ) ) {
+                    add( owner, kind, slot, tag, sidecar::payload_kind::string, str.value() );
+                    return;
+                }
+
+                auto c = get_constant( payload );
+                if ( auto i = llvm::dyn_cast_or_null< llvm::ConstantInt >( c ) ) {
+                    char raw[ sizeof( uint32_t ) + sizeof( uint64_t ) ];
+                    uint32_t bits = i->getBitWidth();
+                    uint64_t value = i->getZExtValue();
+                    std::memcpy( raw, &bits, sizeof( bits ) );
+                    std::memcpy( raw + sizeof( bits ), &value, sizeof( value ) );
+                    add( owner, kind, slot, tag, sidecar::payload_kind::integer, { raw, sizeof( raw ) } );
+                } else if ( auto arr = llvm::dyn_cast_or_null< llvm::ConstantDataArray >( c ) ) {
+                    add( owner, kind, slot, tag, sidecar::payload_kind::bytes, arr->getRawDataValues() );
+                }
+            }
+
+            void add( llvm::StringRef owner, sidecar::slot_kind kind, uint32_t slot, tag_t tag,
+                      sidecar::payload_kind data, llvm::StringRef payload )
+            {
+                entry e{};
+                std::tie( e.owner, e.owner_size ) = string( owner );
+                std::tie( e.tag, e.tag_size ) = string( tag );
+                std::tie( e.payload, e.payload_size ) = string( payload );
+                e.kind = kind;
+                e.data = data;
+                e.slot = slot;
+                entries.push_back( e );
+            }
+
+            // GCC flags the inlined ilist and TrackingMDRef accessors of the
+            // module walk as potential null dereferences
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnull-dereference"
+            template< typename value_t >
+            void attachments( llvm::StringRef owner, sidecar::slot_kind kind, uint32_t slot, value_t *val )
+            {
+                attached.clear();
+                val->getAllMetadata( attached );
+                for ( auto [ k, tuple ] : attached ) {
+                    if ( !custom_kind( k ) || names[ k ] == tag::arguments )
+                        continue;
+                    if ( auto payload = attached_payload( tuple ) )
+                        add( owner, kind, slot, names[ k ], payload );
+                }
+            }
+
+            void collect()
+            {
+                module.getContext().getMDKindNames( names );
+
+                for ( auto &gv : module.globals() ) {
+                    if ( gv.hasName() )
+                        attachments( gv.getName(), sidecar::slot_kind::global, 0, &gv );
+                }
+
+                for ( auto &fn : module ) {
+                    if ( !fn.hasName() )
+                        continue;
+
+                    auto name = fn.getName();
+                    attachments( name, sidecar::slot_kind::global, 0, &fn );
+
+                    if ( auto args = fn.getMetadata( tag::arguments ) ) {
+                        for ( auto &arg : fn.args() ) {
+                            auto payload = llvm::cast< llvm::MDNode >( args->getOperand( arg.getArgNo() ) );
+                            auto str = get_string( payload );
+                            if ( !str || str.value() != tag::none )
+                                add( name, sidecar::slot_kind::argument, arg.getArgNo(), tag::arguments, payload );
+                        }
+                    }
+
+                    uint32_t ordinal = 0;
+                    for ( auto &inst : llvm::instructions( fn ) )
+                        attachments( name, sidecar::slot_kind::instruction, ordinal++, &inst );
+                }
+
+                for ( auto [ gv, ann ] : annotation::enumerate< llvm::GlobalValue >( module ) ) {
+                    if ( gv->hasName() ) {
+                        add( gv->getName(), sidecar::slot_kind::global, 0, annotation_tag,
+                             sidecar::payload_kind::annotation, ann.str() );
+                    }
+                }
+            }
+#pragma GCC diagnostic pop
+
+            void sort()
+            {
+                auto str = [ & ] ( uint32_t off, uint32_t size ) {
+                    return llvm::StringRef( table.data() + off, size );
+                };
+
+                std::stable_sort( entries.begin(), entries.end(), [ & ] ( const entry &a, const entry &b ) {
+                    return std::make_tuple( str( a.owner, a.owner_size ), a.kind, a.slot, str( a.tag, a.tag_size ) )
+                         < std::make_tuple( str( b.owner, b.owner_size ), b.kind, b.slot, str( b.tag, b.tag_size ) );
+                } );
+            }
+
+            llvm::Module &module;
+
+            std::vector< entry > entries;
+            std::string table;
+            llvm::StringMap< uint32_t > offsets;
+
+            llvm::SmallVector< llvm::StringRef, 32 > names;
+            llvm::SmallVector< std::pair< unsigned, llvm::MDNode * >, 4 > attached;
+        };
+
+    } // anonymous namespace
+
+    void sidecar::write( llvm::Module &m, const std::string &path )
+    {
+        writer w( m );
+        w.collect();
+        w.sort();
+
+        std::error_code ec;
+        llvm::raw_fd_ostream os( path, ec, llvm::sys::fs::OF_None );
+        if ( ec )
+            throw std::runtime_error( path + ": " + ec.message() );
+
+        header h{};
+        std::memcpy( h.magic, magic, sizeof( magic ) );
+        h.entries = w.entries.size();
+        h.strings_size = w.table.size();
+
+        os.write( reinterpret_cast< const char * >( &h ), sizeof( h ) );
+        os.write( reinterpret_cast< const char * >( w.entries.data() ), w.entries.size() * sizeof( entry ) );
+        os.write( w.table.data(), w.table.size() );
+
+        // unchecked stream errors are fatal in the destructor
+        os.close();
+        if ( os.has_error() ) {
+            auto err = os.error();
+            os.clear_error();
+            throw std::runtime_error( path + ": " + err.message() );
+        }
+    }
+
+    sidecar sidecar::load( const std::string &path )
+    {
+        auto buffer = llvm::MemoryBuffer::getFile( path, /* text */ false,
+                                                   /* null terminated */ false );
+        if ( !buffer )
+            throw std::runtime_error( path + ": " + buffer.getError().message() );
+        return sidecar( std::move( buffer.get() ) );
+    }
+
+    sidecar::sidecar( std::unique_ptr< llvm::MemoryBuffer > buf )
+        : buffer( std::move( buf ) )
+    {
+        auto data = buffer->getBufferStart();
+        auto size = buffer->getBufferSize();
+
+        header h;
+        if ( size < sizeof( h ) )
+            throw std::runtime_error( "sidecar: truncated header" );
+        std::memcpy( &h, data, sizeof( h ) );
+
+        if ( std::memcmp( h.magic, magic, sizeof( magic ) ) != 0 )
+            throw std::runtime_error( "sidecar: invalid magic" );
+
+        // sizes come from the file, compare without overflowing products
+        uint64_t body = size - sizeof( h );
+        if ( h.entries > body / sizeof( entry ) || h.strings_size != body - h.entries * sizeof( entry ) )
+            throw std::runtime_error( "sidecar: size mismatch" );
+
+        entries = reinterpret_cast< const entry * >( data + sizeof( h ) );
+        count = h.entries;
+        strings = data + sizeof( h ) + count * sizeof( entry );
+
+        auto in_table = [ & ] ( uint32_t off, uint32_t len ) {
+            return off <= h.strings_size && len <= h.strings_size - off;
+        };
+
+        for ( const auto &e : llvm::makeArrayRef( entries, count ) ) {
+            if ( !in_table( e.owner, e.owner_size ) || !in_table( e.tag, e.tag_size )
+                || !in_table( e.payload, e.payload_size ) )
+                throw std::runtime_error( "sidecar: string out of bounds" );
+            if ( e.kind > slot_kind::instruction || e.data > payload_kind::annotation )
+                throw std::runtime_error( "sidecar: invalid entry kind" );
+            if ( e.data == payload_kind::integer && e.payload_size != sizeof( uint32_t ) + sizeof( uint64_t ) )
+                throw std::runtime_error( "sidecar: invalid integer payload" );
+        }
+    }
+
+    llvm::StringRef sidecar::string( uint32_t off, uint32_t size ) const
+    {
+        return { strings + off, size };
+    }
+
+    // GCC flags the inlined DenseMap growth of the renumbering as a potential
+    // null dereference
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnull-dereference"
+    std::optional< sidecar::key > sidecar::id( llvm::Value *val )
+    {
+        if ( auto gv = llvm::dyn_cast< llvm::GlobalValue >( val ) ) {
+            if ( !gv->hasName() )
+                return std::nullopt;
+            return key{ gv->getName(), slot_kind::global, 0 };
+        }
+
+        if ( auto arg = llvm::dyn_cast< llvm::Argument >( val ) ) {
+            auto fn = arg->getParent();
+            if ( !fn->hasName() )
+                return std::nullopt;
+            return key{ fn->getName(), slot_kind::argument, arg->getArgNo() };
+        }
+
+        if ( auto inst = llvm::dyn_cast< llvm::Instruction >( val ) ) {
+            auto bb = inst->getParent();
+            auto fn = bb ? bb->getParent() : nullptr;
+            if ( !fn || !fn->hasName() )
+                return std::nullopt;
+
+            // instructions created since the last numbering of the function
+            // are missing, renumber
+            auto &numbering = ordinals[ fn ];
+            auto it = numbering.find( inst );
+            if ( it == numbering.end() ) {
+                numbering.clear();
+                uint32_t ordinal = 0;
+                for ( auto &i : llvm::instructions( *fn ) )
+                    numbering[ &i ] = ordinal++;
+                it = numbering.find( inst );
+            }
+
+            return key{ fn->getName(), slot_kind::instruction, it->second };
+        }
+
+        return std::nullopt;
+    }
+#pragma GCC diagnostic pop
+
+    auto sidecar::find( const key &k, tag_t tag ) const -> std::pair< const entry *, const entry * >
+    {
+        auto project = [ & ] ( const entry &e ) {
+            return std::make_tuple( string( e.owner, e.owner_size ), e.kind, e.slot, string( e.tag, e.tag_size ) );
+        };
+
+        auto needle = std::make_tuple( k.owner, k.kind, k.slot, tag );
+
+        auto lo = std::partition_point( entries, entries + count, [ & ] ( const entry &e ) {
+            return project( e ) < needle;
+        } );
+        auto hi = std::partition_point( lo, entries + count, [ & ] ( const entry &e ) {
+            return !( needle < project( e ) );
+        } );
+
+        return { lo, hi };
+    }
+
+    auto sidecar::find_one( llvm::Value *val, tag_t tag, payload_kind data ) -> const entry *
+    {
+        auto k = id( val );
+        if ( !k )
+            return nullptr;
+
+        if ( k->kind == slot_kind::argument )
+            tag = tag::arguments;
+
+        auto [ lo, hi ] = find( k.value(), tag );
+        for ( auto e = lo; e != hi; ++e ) {
+            if ( e->data == data )
+                return e;
+        }
+        return nullptr;
+    }
+
+    maybe_meta_str sidecar::get( llvm::Value *val, tag_t tag )
+    {
+        auto e = find_one( val, tag, payload_kind::string );
+        if ( !e || !e->payload_size )
+            return std::nullopt;
+        return string( e->payload, e->payload_size );
+    }
+
+    std::vector< annotation > sidecar::annotations( llvm::GlobalValue *gv )
+    {
+        std::vector< annotation > result;
+
+        if ( auto k = id( gv ) ) {
+            auto [ lo, hi ] = find( k.value(), annotation_tag );
+            for ( auto e = lo; e != hi; ++e )
+                result.emplace_back( string( e->payload, e->payload_size ) );
+        }
+
+        return result;
+    }
+
+} // namespace sc::meta
@@ -0,0 +1,160 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/ssa.hpp>
+
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/Constants.h>
+
+namespace sc::ssa
+{
+    void state::declare( const std::string &var, type ty )
+    {
+        auto [ it, inserted ] = ids.try_emplace( var, var_id( vars.size() ) );
+        if ( inserted )
+            vars.emplace_back( var, ty );
+        else
+            assert( vars[ it->second ].second == ty && "redeclaration with different type" );
+    }
+
+    bool state::declared( const std::string &var ) const
+    {
+        return ids.count( var );
+    }
+
+    state::var_id state::id( const std::string &var ) const
+    {
+        assert( declared( var ) && "use of undeclared ssa variable" );
+        return ids.find( var )->second;
+    }
+
+    void state::write( const std::string &var, basicblock bb, value val )
+    {
+        write( id( var ), bb, val );
+    }
+
+    value state::read( const std::string &var, basicblock bb )
+    {
+        return read( id( var ), bb );
+    }
+
+    void state::write( var_id var, basicblock bb, value val )
+    {
+        assert( val->getType() == vars[ var ].second );
+        defs[ { bb, var } ] = val;
+    }
+
+    value state::read( var_id var, basicblock bb )
+    {
+        if ( auto it = defs.find( { bb, var } ); it != defs.end() && it->second )
+            return it->second;
+        return read_recursive( var, bb );
+    }
+
+    value state::read_recursive( var_id var, basicblock bb )
+    {
+        value val = nullptr;
+        if ( !sealed( bb ) ) {
+            auto phi = make_phi( var, bb );
+            incomplete[ bb ].emplace_back( var, phi );
+            val = phi;
+        } else if ( auto pred = bb->getSinglePredecessor() ) {
+            val = read( var, pred );
+        } else if ( llvm::pred_empty( bb ) ) {
+            val = llvm::UndefValue::get( vars[ var ].second );
+        } else {
+            // break potential cycles with an operandless phi
+            auto phi = make_phi( var, bb );
+            write( var, bb, phi );
+            val = add_phi_operands( var, phi );
+        }
+
+        write( var, bb, val );
+        return val;
+    }
+
+    phi_node state::make_phi( var_id var, basicblock bb )
+    {
+        const auto &name = vars[ var ].first;
+        auto ty = vars[ var ].second;
+        auto phi = [ & ] {
+            if ( auto first = bb->getFirstNonPHI() )
+                return llvm::PHINode::Create( ty, 0, name, first );
+            return llvm::PHINode::Create( ty, 0, name, bb );
+        } ();
+        phis.insert( phi );
+        return phi;
+    }
+
+    value state::add_phi_operands( var_id var, phi_node phi )
+    {
+        auto bb = phi->getParent();
+        for ( auto pred : llvm::predecessors( bb ) )
+            phi->addIncoming( read( var, pred ), pred );
+        return try_remove_trivial_phi( phi );
+    }
+
+    value state::try_remove_trivial_phi( phi_node phi )
+    {
+        value same = nullptr;
+        for ( auto &op : phi->incoming_values() ) {
+            if ( op == same || op == phi )
+                continue;
+            if ( same )
+                return phi; // merges at least two values
+            same = op;
+        }
+
+        if ( !same ) // unreachable or in the entry block
+            same = llvm::UndefValue::get( phi->getType() );
+
+        std::vector< llvm::WeakVH > users;
+        for ( auto user : phi->users() )
+            if ( auto p = llvm::dyn_cast< llvm::PHINode >( user ); p && p != phi && phis.count( p ) )
+                users.emplace_back( p );
+
+        phi->replaceAllUsesWith( same );
+        phis.erase( phi );
+        phi->eraseFromParent();
+
+        // removal may have made other phis trivial, even 'same' itself
+        llvm::WeakTrackingVH result = same;
+        for ( auto &user : users )
+            if ( user )
+                try_remove_trivial_phi( llvm::cast< llvm::PHINode >( user ) );
+
+        return result;
+    }
+
+    void state::seal( basicblock bb )
+    {
+        if ( !sealed_blocks.insert( bb ).second )
+            return;
+
+        if ( auto it = incomplete.find( bb ); it != incomplete.end() ) {
+            auto pending = std::move( it->second );
+            incomplete.erase( it );
+            for ( auto [ var, phi ] : pending )
+                add_phi_operands( var, phi );
+        }
+    }
+
+    bool state::sealed( basicblock bb ) const
+    {
+        return sealed_blocks.count( bb );
+    }
+
+} // namespace sc::ssa
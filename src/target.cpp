@@ -0,0 +1,104 @@
+/*
+ * (c) 2022 Henrich Lauko <xlauko@mail.muni.cz>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sc/target.hpp>
+
+#include <sc/warnings.hpp>
+
+SC_RELAX_WARNINGS
+#include <llvm/IR/Module.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetMachine.h>
+SC_UNRELAX_WARNINGS
+
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace sc
+{
+    void init_native_target()
+    {
+        static std::once_flag flag;
+        std::call_once( flag, [] {
+            llvm::InitializeNativeTarget();
+            llvm::InitializeNativeTargetAsmPrinter();
+            llvm::InitializeNativeTargetAsmParser();
+        } );
+    }
+
+    namespace
+    {
+        llvm::OptimizationLevel pipeline_level( opt_level level )
+        {
+            switch ( level ) {
+                case opt_level::O1: return llvm::OptimizationLevel::O1;
+                case opt_level::O2: return llvm::OptimizationLevel::O2;
+                case opt_level::O3: return llvm::OptimizationLevel::O3;
+                default: return llvm::OptimizationLevel::O0;
+            }
+        }
+
+        llvm::CodeGenOpt::Level codegen_level( opt_level level )
+        {
+            switch ( level ) {
+                case opt_level::O1: return llvm::CodeGenOpt::Less;
+                case opt_level::O2: return llvm::CodeGenOpt::Default;
+                case opt_level::O3: return llvm::CodeGenOpt::Aggressive;
+                default: return llvm::CodeGenOpt::None;
+            }
+        }
+
+    } // anonymous namespace
+
+    void optimize( llvm::Module &m, opt_level level )
+    {
+        llvm::LoopAnalysisManager lam;
+        llvm::FunctionAnalysisManager fam;
+        llvm::CGSCCAnalysisManager cgam;
+        llvm::ModuleAnalysisManager mam;
+
+        llvm::PassBuilder pb;
+        pb.registerModuleAnalyses( mam );
+        pb.registerCGSCCAnalyses( cgam );
+        pb.registerFunctionAnalyses( fam );
+        pb.registerLoopAnalyses( lam );
+        pb.crossRegisterProxies( lam, fam, cgam, mam );
+
+        pb.buildPerModuleDefaultPipeline( pipeline_level( level ) ).run( m, mam );
+    }
+
+    std::unique_ptr< llvm::TargetMachine > native_target_machine( opt_level level )
+    {
+        init_native_target();
+
+        auto triple = llvm::sys::getDefaultTargetTriple();
+
+        std::string error;
+        auto target = llvm::TargetRegistry::lookupTarget( triple, error );
+        if ( !target )
+            throw std::runtime_error( error );
+
+        return std::unique_ptr< llvm::TargetMachine >( target->createTargetMachine(
+            triple, "generic", "", llvm::TargetOptions(), llvm::Reloc::PIC_,
+            llvm::None, codegen_level( level )
+        ) );
+    }
+
+} // namespace sc
@@ -17,6 +17,7 @@
 #include <sc/types.hpp>
 #include <sc/context.hpp>
 
+#include <llvm/IR/Instructions.h>
 #include <llvm/IR/Type.h>
 
 namespace sc
@@ -45,6 +46,11 @@ namespace sc
     ptr_type i32p  ( unsigned as ) { return Type::getInt32PtrTy( context(), as ); }
     ptr_type i64p  ( unsigned as ) { return Type::getInt64PtrTy( context(), as ); }
 
+    vec_type vec( type element, unsigned n )
+    {
+        return llvm::FixedVectorType::get( element, n );
+    }
+
     unsigned bits( type ty, const data_layout_t &dl )
     {
         return unsigned( dl.getTypeSizeInBits( ty ).getFixedSize() );
@@ -65,4 +71,26 @@ namespace sc
         return bytes( v->getType(), data_layout( v ) );
     }
 
+    type field_type( type ty, const std::vector< unsigned > &path )
+    {
+        for ( auto idx : path )
+            ty = llvm::GetElementPtrInst::getTypeAtIndex( ty, uint64_t( idx ) );
+        return ty;
+    }
+
+    uint64_t offset( type ty, const std::vector< unsigned > &path, const data_layout_t &dl )
+    {
+        uint64_t off = 0;
+        for ( auto idx : path ) {
+            if ( auto st = llvm::dyn_cast< llvm::StructType >( ty ) ) {
+                off += dl.getStructLayout( st )->getElementOffset( idx );
+                ty = st->getElementType( idx );
+            } else {
+                ty = llvm::GetElementPtrInst::getTypeAtIndex( ty, uint64_t( idx ) );
+                off += idx * dl.getTypeAllocSize( ty ).getFixedSize();
+            }
+        }
+        return off;
+    }
+
 } // namespace sc
@@ -1,5 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <sc/annotation.hpp>
+#include <sc/annotation_index.hpp>
+#include <sc/annotation_writer.hpp>
+
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/Support/SourceMgr.h>
 
 TEST_CASE( "annotation" )
 {
@@ -9,3 +15,144 @@ TEST_CASE( "annotation" )
         REQUIRE( a.str() == "lart.abstract" );
     }
 }
+
+static const char *annotated_source = R"(
+@x = global i32 0
+@.a = private unnamed_addr constant [11 x i8] c"sc.test.ns\00", section "llvm.metadata"
+@.b = private unnamed_addr constant [14 x i8] c"sc.test.other\00", section "llvm.metadata"
+@.c = private unnamed_addr constant [8 x i8] c"sc.test\00", section "llvm.metadata"
+@llvm.global.annotations = appending global [3 x { i8*, i8*, i8*, i32, i8* }] [
+    { i8*, i8*, i8*, i32, i8* } { i8* bitcast (i32* @x to i8*),
+      i8* getelementptr inbounds ([11 x i8], [11 x i8]* @.a, i32 0, i32 0), i8* null, i32 0, i8* null },
+    { i8*, i8*, i8*, i32, i8* } { i8* bitcast (void ()* @f to i8*),
+      i8* getelementptr inbounds ([14 x i8], [14 x i8]* @.b, i32 0, i32 0), i8* null, i32 0, i8* null },
+    { i8*, i8*, i8*, i32, i8* } { i8* bitcast (void ()* @f to i8*),
+      i8* getelementptr inbounds ([8 x i8], [8 x i8]* @.c, i32 0, i32 0), i8* null, i32 0, i8* null } ],
+    section "llvm.metadata"
+
+define void @f() {
+  ret void
+}
+)";
+
+TEST_CASE( "annotation index" )
+{
+    llvm::LLVMContext ctx;
+    llvm::SMDiagnostic err;
+    auto m = llvm::parseAssemblyString( annotated_source, err, ctx );
+    REQUIRE( m );
+
+    sc::annotation_index index( *m );
+
+    auto count = [] ( auto &&gen ) {
+        std::size_t n = 0;
+        for ( auto &&ann : gen ) {
+            static_cast< void >( ann );
+            ++n;
+        }
+        return n;
+    };
+
+    auto test = sc::annotation( "sc", "test" );
+
+    SECTION( "namespace" )
+    {
+        REQUIRE( index.size() == 3 );
+        REQUIRE( count( index.in_namespace< llvm::GlobalValue >( test ) ) == 2 );
+        REQUIRE( count( index.in_namespace< llvm::Function >( test ) ) == 1 );
+        REQUIRE( count( index.in_namespace< llvm::GlobalVariable >( test ) ) == 1 );
+        REQUIRE( count( index.all< llvm::Function >() ) == 2 );
+        REQUIRE( count( index.in_namespace< llvm::Function >( sc::annotation( "none" ) ) ) == 0 );
+        REQUIRE( count( index.in_namespace< llvm::GlobalObject >( test ) ) == 2 );
+        REQUIRE( count( index.in_namespace< llvm::GlobalAlias >( test ) ) == 0 );
+        REQUIRE( count( index.find< llvm::GlobalAlias >( test ) ) == 0 );
+
+        for ( auto [ fn, ann ] : index.find< llvm::Function >( test ) ) {
+            REQUIRE( fn == m->getFunction( "f" ) );
+            REQUIRE( ann == test );
+        }
+    }
+
+    SECTION( "invalidation" )
+    {
+        REQUIRE( index.size() == 3 );
+
+        auto annos = m->getNamedGlobal( "llvm.global.annotations" );
+        auto arr = llvm::cast< llvm::ConstantArray >( annos->getInitializer() );
+        auto ty = llvm::ArrayType::get( arr->getType()->getElementType(), 1 );
+        auto shrunk = new llvm::GlobalVariable( *m, ty, false, annos->getLinkage(),
+            llvm::ConstantArray::get( ty, { arr->getOperand( 0 ) } ) );
+        annos->eraseFromParent();
+        shrunk->setName( "llvm.global.annotations" );
+
+        REQUIRE( index.size() == 1 );
+        REQUIRE( count( index.all< llvm::Function >() ) == 0 );
+    }
+
+    SECTION( "string edit" )
+    {
+        REQUIRE( count( index.in_namespace< llvm::Function >( test ) ) == 1 );
+
+        auto str = m->getNamedGlobal( ".b" );
+        str->setInitializer( llvm::ConstantDataArray::getString( ctx, "sc.other.abcd" ) );
+        sc::annotation_index::changed();
+
+        REQUIRE( count( index.in_namespace< llvm::Function >( test ) ) == 0 );
+        REQUIRE( count( index.in_namespace< llvm::Function >( sc::annotation( "sc", "other" ) ) ) == 1 );
+    }
+}
+
+TEST_CASE( "annotation writer" )
+{
+    llvm::LLVMContext ctx;
+    llvm::SMDiagnostic err;
+    auto m = llvm::parseAssemblyString( annotated_source, err, ctx );
+    REQUIRE( m );
+
+    auto globals = m->global_size();
+
+    auto x = m->getNamedGlobal( "x" );
+    auto f = m->getFunction( "f" );
+
+    sc::annotation_writer writer( *m );
+    writer.add( f, sc::annotation( "sc", "test", "ns" ) );
+    writer.add( x, sc::annotation( "sc", "fresh" ) );
+    writer.add( f, sc::annotation( "sc", "fresh" ) );
+    writer.finalize();
+
+    REQUIRE( writer.pending() == 0 );
+    // one new string, the array is replaced
+    REQUIRE( m->global_size() == globals + 1 );
+
+    sc::annotation_index index( *m );
+    REQUIRE( index.size() == 6 );
+
+    std::size_t fresh = 0;
+    for ( auto &&ann : index.find< llvm::GlobalValue >( sc::annotation( "sc", "fresh" ) ) ) {
+        static_cast< void >( ann );
+        ++fresh;
+    }
+    REQUIRE( fresh == 2 );
+}
+
+TEST_CASE( "annotation enumerate", "[.benchmark]" )
+{
+    llvm::LLVMContext ctx;
+    llvm::SMDiagnostic err;
+    auto m = llvm::parseAssemblyString( annotated_source, err, ctx );
+    REQUIRE( m );
+
+    auto ns = sc::annotation( "sc", "test" );
+
+    BENCHMARK( "enumerate in namespace" )
+    {
+        std::size_t n = 0;
+        for ( int i = 0; i < 1000; ++i ) {
+            for ( auto &&ann : sc::annotation::enumerate_in_namespace< llvm::Function >( ns, *m ) ) {
+                static_cast< void >( ann );
+                ++n;
+            }
+        }
+        return n;
+    };
+}
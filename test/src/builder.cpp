@@ -3,6 +3,8 @@
 #include <sc/constant.hpp>
 #include <sc/init.hpp>
 
+#include <llvm/IR/IntrinsicInst.h>
+
 #include <utils.hpp>
 
 TEST_CASE( "builder" )
@@ -68,4 +70,341 @@ TEST_CASE( "builder" )
         REQUIRE( llvm::cast< llvm::Instruction >( inst )->getOpcode()
                  == llvm::Instruction::Add );
     }
+
+    SECTION( "ssa" )
+    {
+        using namespace sc::literals;
+
+        builder = std::move(builder)
+          | sc::action::ssa_mode()
+          | sc::action::create_block{ "entry" }
+          | sc::action::create_block{ "then" }
+          | sc::action::create_block{ "merge" };
+
+        auto tbb = builder.block( "then" );
+        auto mbb = builder.block( "merge" );
+
+        auto phi = std::move(builder)
+          | sc::action::set_block{ "entry" }
+          | sc::action::seal_block{}
+          | sc::action::alloc( sc::i8(), "x" )
+          | sc::action::store{ 1_i8, {}, "x" }
+          | sc::action::condbr( sc::i1( true ), tbb, mbb )
+          | sc::action::set_block{ "then" }
+          | sc::action::seal_block{}
+          | sc::action::store{ 2_i8, {}, "x" }
+          | sc::action::branch{ mbb }
+          | sc::action::set_block{ "merge" }
+          | sc::action::load( sc::i8(), "x" )
+          | sc::action::seal_all()
+          | sc::action::last();
+
+        REQUIRE( llvm::isa< llvm::PHINode >( phi ) );
+        REQUIRE( llvm::cast< llvm::PHINode >( phi )->getNumIncomingValues() == 2 );
+
+        // neither allocas nor stores are emitted in the entry block
+        auto entry = llvm::cast< llvm::PHINode >( phi )->getIncomingBlock( 0 );
+        REQUIRE( entry->getTerminator() == entry->getFirstNonPHIOrDbg() );
+    }
+
+    SECTION( "ssa trivial phi" )
+    {
+        using namespace sc::literals;
+
+        builder = std::move(builder)
+          | sc::action::ssa_mode()
+          | sc::action::create_block{ "entry" }
+          | sc::action::create_block{ "loop" };
+
+        auto lbb = builder.block( "loop" );
+
+        auto inc = std::move(builder)
+          | sc::action::set_block{ "entry" }
+          | sc::action::alloc( sc::i8(), "x" )
+          | sc::action::store{ 7_i8, {}, "x" }
+          | sc::action::branch{ lbb }
+          | sc::action::set_block{ "loop" }
+          | sc::action::load( sc::i8(), "x" )
+          | sc::action::add{ {}, 1_i8 }
+          | sc::action::branch{ lbb }
+          | sc::action::seal_all()
+          | sc::action::pop()
+          | sc::action::last();
+
+        // the incomplete phi in the loop header is replaced by the definition
+        REQUIRE( !llvm::isa< llvm::PHINode >( lbb->front() ) );
+        REQUIRE( llvm::cast< llvm::Instruction >( inc )->getOperand( 0 ) == 7_i8 );
+    }
+
+    SECTION( "folding" )
+    {
+        using namespace sc::literals;
+
+        auto bld = std::move(builder)
+          | sc::action::fold()
+          | sc::action::create_block{ "folding-test" }
+          | sc::action::alloc( sc::i8(), "a" )
+          | sc::action::load( sc::i8(), "a" );
+
+        auto x = bld.pop();
+
+        sc::fold_stats stats;
+        auto cmp = std::move(bld)
+          | sc::action::add{ x, 5_i8 }
+          | sc::action::add{ 5_i8, x }
+          | sc::action::eq()
+          | sc::action::inspect( [&] ( auto *b ) { stats = b->builder->stats(); } )
+          | sc::action::last();
+
+        // the second add is reused, the comparison of equal values folds
+        REQUIRE( cmp == sc::i1( true ) );
+        REQUIRE( stats.reused == 1 );
+        REQUIRE( stats.simplified == 1 );
+    }
+
+    SECTION( "ssa folding" )
+    {
+        using namespace sc::literals;
+
+        builder = std::move(builder)
+          | sc::action::ssa_mode()
+          | sc::action::fold()
+          | sc::action::create_block{ "entry" }
+          | sc::action::create_block{ "left" }
+          | sc::action::create_block{ "right" }
+          | sc::action::create_block{ "join" };
+
+        auto lbb = builder.block( "left" );
+        auto rbb = builder.block( "right" );
+        auto jbb = builder.block( "join" );
+
+        // the trivial phi of 'x' is erased on sealing, the phi of 'y' may
+        // reuse its address and must not pick up the stale 'x + 1'
+        auto inc = std::move(builder)
+          | sc::action::set_block{ "entry" }
+          | sc::action::seal_block{}
+          | sc::action::alloc( sc::i8(), "x" )
+          | sc::action::alloc( sc::i8(), "y" )
+          | sc::action::store{ 7_i8, {}, "x" }
+          | sc::action::condbr( sc::i1( true ), lbb, rbb )
+          | sc::action::set_block{ "left" }
+          | sc::action::seal_block{}
+          | sc::action::store{ 2_i8, {}, "y" }
+          | sc::action::branch{ jbb }
+          | sc::action::set_block{ "right" }
+          | sc::action::seal_block{}
+          | sc::action::store{ 3_i8, {}, "y" }
+          | sc::action::branch{ jbb }
+          | sc::action::set_block{ "join" }
+          | sc::action::load( sc::i8(), "x" )
+          | sc::action::add{ {}, 1_i8 }
+          | sc::action::pop()
+          | sc::action::seal_block{}
+          | sc::action::load( sc::i8(), "y" )
+          | sc::action::add{ {}, 1_i8 }
+          | sc::action::last();
+
+        REQUIRE( llvm::isa< llvm::Instruction >( inc ) );
+        REQUIRE( llvm::isa< llvm::PHINode >( llvm::cast< llvm::Instruction >( inc )->getOperand( 0 ) ) );
+    }
+
+    SECTION( "vector" )
+    {
+        using namespace sc::literals;
+
+        auto red = std::move(builder)
+          | sc::action::create_block{ "vector-test" }
+          | sc::action::alloc( sc::i8(), "a" )
+          | sc::action::load( sc::i8(), "a" )
+          | sc::action::splat{ 8, {} }
+          | sc::action::insertelement{ {}, 1_i8, 0_i32 }
+          | sc::action::reduce_add()
+          | sc::action::last();
+
+        auto call = llvm::cast< llvm::IntrinsicInst >( red );
+        REQUIRE( call->getIntrinsicID() == llvm::Intrinsic::vector_reduce_add );
+
+        auto ins = llvm::cast< llvm::InsertElementInst >( call->getArgOperand( 0 ) );
+        REQUIRE( ins->getType() == sc::vec( sc::i8(), 8 ) );
+        REQUIRE( llvm::isa< llvm::ShuffleVectorInst >( ins->getOperand( 0 ) ) );
+    }
+
+    SECTION( "loop" )
+    {
+        using namespace sc::literals;
+
+        std::vector< unsigned > widths;
+        auto body = [&] ( sc::stack_builder &&b, sc::value iv, unsigned width ) {
+            widths.push_back( width );
+            return std::move(b) | sc::action::add{ iv, 1_i32 } | sc::action::pop();
+        };
+
+        auto bld = std::move(builder)
+          | sc::action::create_block{ "loop-test" }
+          | sc::action::alloc( sc::i32(), "n" )
+          | sc::action::load( sc::i32(), "n" )
+          | sc::action::loop( {}, 1, body, 2, 4 );
+
+        // unrolled vector main loop and scalar remainder
+        REQUIRE( widths == std::vector< unsigned >{ 4, 4, 1 } );
+        REQUIRE( bld.current_block == bld.block( "loop.1.exit" ) );
+
+        auto header = bld.block( "loop.0.header" );
+        auto iv = llvm::cast< llvm::PHINode >( &header->front() );
+        REQUIRE( iv->getNumIncomingValues() == 2 );
+        REQUIRE( iv->getIncomingBlock( 1 ) == bld.block( "loop.0.latch" ) );
+        REQUIRE( llvm::isa< llvm::AllocaInst >( bld.back() ) ); // count was consumed
+    }
+
+    SECTION( "dispatch" )
+    {
+        auto bld = std::move(builder)
+          | sc::action::create_block{ "dispatch-test" }
+          | sc::action::create_block{ "a" }
+          | sc::action::create_block{ "b" }
+          | sc::action::create_block{ "default" }
+          | sc::action::set_block{ "dispatch-test" }
+          | sc::action::alloc( sc::i32(), "x" );
+
+        auto a = bld.block( "a" ), b = bld.block( "b" ), def = bld.block( "default" );
+        auto cases = [&] ( std::vector< uint32_t > vals ) {
+            std::vector< sc::switch_case > res;
+            for ( auto v : vals )
+                res.push_back( { sc::i32( v ), v % 2 ? a : b } );
+            return res;
+        };
+
+        SECTION( "dense" )
+        {
+            auto br = std::move(bld)
+              | sc::action::load( sc::i32(), "x" )
+              | sc::action::dispatch{ {}, def, cases( { 1, 2, 3, 5, 6 } ) }
+              | sc::action::last();
+
+            auto ibr = llvm::cast< llvm::IndirectBrInst >( br );
+            REQUIRE( ibr->getNumDestinations() == 3 );
+        }
+
+        SECTION( "sparse" )
+        {
+            auto br = std::move(bld)
+              | sc::action::load( sc::i32(), "x" )
+              | sc::action::dispatch{ {}, def, cases( { 1, 20, 300, 4000 } ) }
+              | sc::action::last();
+
+            auto sw = llvm::cast< llvm::SwitchInst >( br );
+            REQUIRE( sw->getNumCases() == 4 );
+            REQUIRE( sw->getDefaultDest() == def );
+        }
+
+        SECTION( "negative" )
+        {
+            auto br = std::move(bld)
+              | sc::action::load( sc::i32(), "x" )
+              | sc::action::dispatch{ {}, def, cases( { 0xfffffffe, 0xffffffff, 0, 1, 2 } ) }
+              | sc::action::last();
+
+            REQUIRE( llvm::isa< llvm::IndirectBrInst >( br ) );
+            auto table = llvm::cast< llvm::Instruction >( br )->getModule()->getNamedGlobal( "dispatch.table" );
+            REQUIRE( table->getValueType()->getArrayNumElements() == 5 );
+        }
+
+        SECTION( "full range" )
+        {
+            std::vector< sc::switch_case > all;
+            for ( unsigned v = 0; v < 256; ++v )
+                all.push_back( { sc::i8( static_cast< uint8_t >( v ) ), v % 2 ? a : b } );
+
+            auto entry = bld.block( "dispatch-test" );
+            auto br = std::move(bld)
+              | sc::action::alloc( sc::i8(), "y" )
+              | sc::action::load( sc::i8(), "y" )
+              | sc::action::dispatch{ {}, def, std::move( all ) }
+              | sc::action::last();
+
+            REQUIRE( llvm::isa< llvm::IndirectBrInst >( br ) );
+
+            // the bound check covers every value of the type
+            auto guard = llvm::cast< llvm::BranchInst >( entry->getTerminator() );
+            auto in = llvm::cast< llvm::ICmpInst >( guard->getCondition() );
+            REQUIRE( in->getPredicate() == llvm::ICmpInst::ICMP_ULE );
+            REQUIRE( llvm::cast< llvm::ConstantInt >( in->getOperand( 1 ) )->isMinusOne() );
+        }
+
+        SECTION( "empty" )
+        {
+            auto dispatch = sc::action::dispatch{ {}, def, {} };
+            dispatch.min_cases = 0;
+
+            auto br = std::move(bld)
+              | sc::action::load( sc::i32(), "x" )
+              | std::move( dispatch )
+              | sc::action::last();
+
+            auto sw = llvm::cast< llvm::SwitchInst >( br );
+            REQUIRE( sw->getNumCases() == 0 );
+            REQUIRE( sw->getDefaultDest() == def );
+        }
+    }
+
+    SECTION( "field" )
+    {
+        auto arr = llvm::ArrayType::get( sc::i16(), 4 );
+        auto ty  = llvm::StructType::get( ctx, { sc::i8(), sc::i32(), arr } );
+
+        auto bld = std::move(builder)
+          | sc::action::create_block{ "field-test" }
+          | sc::action::alloc( ty, "s" );
+
+        auto base = bld.back();
+        auto &dl = bld.module->getDataLayout();
+        REQUIRE( sc::offset( ty, { 2, 3 }, dl ) == 14 );
+
+        SECTION( "typed" )
+        {
+            auto addr = std::move(bld)
+              | sc::action::field{ ty, {}, { 2 } }
+              | sc::action::field{ arr, {}, { 3 } }
+              | sc::action::last();
+
+            // constant chain is folded to a single gep
+            auto gep = llvm::cast< llvm::GetElementPtrInst >( addr );
+            REQUIRE( gep->isInBounds() );
+            REQUIRE( gep->getPointerOperand() == base );
+            REQUIRE( gep->getNumIndices() == 3 );
+            REQUIRE( gep->getResultElementType() == sc::i16() );
+
+            // the merged inner gep is not left behind
+            REQUIRE( gep->getPrevNode() == base );
+        }
+
+        SECTION( "shared base" )
+        {
+            auto bld2 = std::move(bld)
+              | sc::action::field{ ty, {}, { 2 } };
+            auto inner = bld2.back();
+
+            // an explicitly passed pointer stays valid for further accesses
+            auto addr = std::move(bld2)
+              | sc::action::field{ arr, inner, { 3 } }
+              | sc::action::field{ arr, inner, { 1 } }
+              | sc::action::last();
+
+            REQUIRE( llvm::cast< llvm::GetElementPtrInst >( addr )->getPointerOperand() == base );
+            REQUIRE( llvm::cast< llvm::Instruction >( inner )->getParent() );
+        }
+
+        SECTION( "bytes" )
+        {
+            auto addr = std::move(bld)
+              | sc::action::bitcast( {}, sc::i8p() )
+              | sc::action::field{ ty, {}, { 2, 3 } }
+              | sc::action::last();
+
+            auto cast = llvm::cast< llvm::BitCastInst >( addr );
+            REQUIRE( cast->getDestTy() == sc::i16p() );
+            auto gep = llvm::cast< llvm::GetElementPtrInst >( cast->getOperand( 0 ) );
+            REQUIRE( llvm::cast< llvm::ConstantInt >( gep->getOperand( 1 ) )->getZExtValue() == 14 );
+        }
+    }
 }
@@ -0,0 +1,59 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sc/builder.hpp>
+#include <sc/codegen.hpp>
+#include <sc/init.hpp>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+
+#include <stdexcept>
+
+#include <utils.hpp>
+
+TEST_CASE( "codegen" )
+{
+    sc::context_t ctx;
+    sc::init( ctx );
+
+    std::unique_ptr< llvm::Module > m( sc::empty_module() );
+    for ( int i = 0; i < 8; ++i ) {
+        auto bld = sc::stack_builder()
+              | sc::action::module{ m.get() }
+              | sc::action::create_function{ "f" + std::to_string( i ), sc::i32(), { sc::i32() } }
+              | sc::action::create_block{ "entry" };
+
+        auto fn = bld.functions.back();
+        std::move( bld )
+              | sc::action::mul{ fn->getArg( 0 ), fn->getArg( 0 ) }
+              | sc::action::ret{};
+    }
+
+    SECTION( "partitions" )
+    {
+        auto objects = sc::codegen( sc::opt_level::O1 ).emit( *m, 4 );
+        REQUIRE( objects.size() == 4 );
+        REQUIRE( m->size() == 8 );
+    }
+
+    SECTION( "deterministic" )
+    {
+        auto serial   = sc::codegen( sc::opt_level::O2, 1 ).emit( *m, 4 );
+        auto parallel = sc::codegen( sc::opt_level::O2, 4 ).emit( *m, 4 );
+        REQUIRE( serial == parallel );
+    }
+
+    SECTION( "write error" )
+    {
+        if ( !llvm::sys::fs::exists( "/dev/full" ) )
+            return;
+
+        // the first object file is redirected to a device that fails every write
+        llvm::SmallString< 64 > dir;
+        REQUIRE( !llvm::sys::fs::createUniqueDirectory( "sc", dir ) );
+        auto prefix = ( dir + "/part" ).str();
+        REQUIRE( !llvm::sys::fs::create_link( "/dev/full", prefix + ".0.o" ) );
+
+        REQUIRE_THROWS_AS( sc::codegen( sc::opt_level::O1 ).write( *m, 1, prefix ), std::runtime_error );
+        llvm::sys::fs::remove_directories( dir );
+    }
+}
@@ -0,0 +1,89 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sc/erase.hpp>
+
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/ValueSymbolTable.h>
+#include <llvm/Support/SourceMgr.h>
+
+#include <set>
+
+static const char *dead_source = R"(
+define i32 @fn(i32 %x) {
+entry:
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %a
+  %c = sub i32 %b, %a
+  %d = add i32 %c, %x
+  ret i32 %d
+}
+)";
+
+TEST_CASE( "batch eraser" )
+{
+    llvm::LLVMContext ctx;
+    llvm::SMDiagnostic err;
+    auto m = llvm::parseAssemblyString( dead_source, err, ctx );
+    REQUIRE( m );
+
+    auto fn = m->getFunction( "fn" );
+    auto inst = [&] ( const char *name ) {
+        return llvm::cast< llvm::Instruction >( fn->getValueSymbolTable()->lookup( name ) );
+    };
+
+    auto a = inst( "a" ), b = inst( "b" ), c = inst( "c" ), d = inst( "d" );
+
+    SECTION( "dead chain" )
+    {
+        auto ret = fn->getEntryBlock().getTerminator();
+        ret->setOperand( 0, fn->getArg( 0 ) );
+
+        sc::batch_eraser eraser;
+        // users before their operands and duplicates
+        REQUIRE( eraser.push( a ) );
+        REQUIRE( eraser.push( c ) );
+        REQUIRE_FALSE( eraser.push( a ) );
+        REQUIRE( eraser.push( b ) );
+        REQUIRE( eraser.push( d ) );
+        REQUIRE( eraser.size() == 4 );
+
+        auto stats = eraser.erase();
+        REQUIRE( stats.erased == 4 );
+        REQUIRE( stats.duplicates == 1 );
+        REQUIRE( stats.replaced_uses == 0 );
+        REQUIRE( eraser.empty() );
+        REQUIRE( fn->getInstructionCount() == 1 );
+    }
+
+    SECTION( "surviving uses" )
+    {
+        sc::batch_eraser eraser;
+        eraser.push( c );
+        eraser.push( d );
+
+        auto stats = eraser.erase();
+        REQUIRE( stats.erased == 2 );
+        REQUIRE( stats.replaced_uses == 1 );
+
+        auto ret = llvm::cast< llvm::ReturnInst >( fn->getEntryBlock().getTerminator() );
+        REQUIRE( llvm::isa< llvm::UndefValue >( ret->getReturnValue() ) );
+        REQUIRE( fn->getInstructionCount() == 3 );
+    }
+
+    SECTION( "deferred erase vector" )
+    {
+        std::set< llvm::Instruction * > deleted;
+        {
+            auto del = [&] ( llvm::Instruction *i ) { deleted.insert( i ); };
+            sc::deferred_erase_vector< decltype( del ) > vec( del );
+            vec.push( d );
+            vec.push( b );
+            vec.push( c );
+            vec.push( d );
+        }
+
+        REQUIRE( deleted == std::set< llvm::Instruction * >{ b, c, d } );
+        REQUIRE( fn->getInstructionCount() == 2 );
+    }
+}
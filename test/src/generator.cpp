@@ -0,0 +1,89 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sc/recursive_generator.hpp>
+
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    sc::recursive_generator< int > range( int from, int to )
+    {
+        for ( int i = from; i < to; ++i )
+            co_yield i;
+    }
+
+    // yields 0..n-1 nested n levels deep
+    sc::recursive_generator< int > nested( int n )
+    {
+        if ( n == 0 )
+            co_return;
+        co_yield nested( n - 1 );
+        co_yield n - 1;
+    }
+
+    sc::recursive_generator< int > failing()
+    {
+        co_yield 1;
+        throw std::runtime_error( "failing" );
+    }
+
+    template< typename generator >
+    std::vector< int > collect( generator &&gen )
+    {
+        std::vector< int > res;
+        for ( int v : gen )
+            res.push_back( v );
+        return res;
+    }
+
+} // anonymous namespace
+
+TEST_CASE( "recursive generator" )
+{
+    SECTION( "flat" )
+    {
+        REQUIRE( collect( range( 0, 3 ) ) == std::vector< int >{ 0, 1, 2 } );
+    }
+
+    SECTION( "nested" )
+    {
+        auto res = collect( nested( 1000 ) );
+        REQUIRE( res.size() == 1000 );
+        REQUIRE( res.front() == 0 );
+        REQUIRE( res.back() == 999 );
+    }
+
+    SECTION( "empty nested" )
+    {
+        auto gen = [] () -> sc::recursive_generator< int > {
+            co_yield range( 0, 0 );
+            co_yield 7;
+            co_yield range( 0, 0 );
+        };
+        REQUIRE( collect( gen() ) == std::vector< int >{ 7 } );
+    }
+
+    SECTION( "exception" )
+    {
+        auto gen = [] () -> sc::recursive_generator< int > {
+            co_yield failing();
+            co_yield 2;
+        };
+        REQUIRE_THROWS_AS( collect( gen() ), std::runtime_error );
+    }
+
+    SECTION( "freed at thread exit" )
+    {
+        // 'late' is constructed before the frame pool of the thread, so it
+        // is destroyed after it and frees its frame into a dead pool
+        int first = -1;
+        std::thread( [ &first ] {
+            thread_local std::optional< sc::recursive_generator< int > > late;
+            late.emplace( range( 0, 3 ) );
+            first = *late->begin();
+        } ).join();
+        REQUIRE( first == 0 );
+    }
+}
@@ -0,0 +1,97 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sc/builder.hpp>
+#include <sc/constant.hpp>
+#include <sc/init.hpp>
+#include <sc/jit.hpp>
+
+#include <utils.hpp>
+
+TEST_CASE( "jit" )
+{
+    sc::context_t ctx;
+    sc::init( ctx );
+
+    auto bld = sc::stack_builder()
+          | sc::action::module{ sc::empty_module() }
+          | sc::action::create_function{ "mad", sc::i32(), { sc::i32(), sc::i32() } }
+          | sc::action::create_block{ "entry" };
+
+    auto fn = bld.functions.back();
+    std::move( bld )
+          | sc::action::mul{ fn->getArg( 0 ), fn->getArg( 1 ) }
+          | sc::action::add{ {}, fn->getArg( 0 ) }
+          | sc::action::ret{};
+
+    std::unique_ptr< llvm::Module > m( fn->getParent() );
+
+    SECTION( "call" )
+    {
+        sc::jit engine;
+        engine.add( *m );
+
+        auto mad = engine.lookup< int( int, int ) >( "mad" );
+        REQUIRE( mad( 3, 4 ) == 15 );
+    }
+
+    SECTION( "cache" )
+    {
+        auto cache = std::make_shared< sc::object_cache >();
+        for ( int i = 0; i < 2; ++i ) {
+            sc::jit engine( sc::opt_level::O2, cache );
+            engine.add( *m );
+            REQUIRE( engine.lookup< int( int, int ) >( "mad" )( 2, 5 ) == 12 );
+        }
+
+        REQUIRE( cache->hits() > 0 );
+    }
+}
+
+TEST_CASE( "jit loop" )
+{
+    sc::context_t ctx;
+    sc::init( ctx );
+
+    // counts steps of 'for ( iv = start; iv < count; iv += 7 )'
+    auto body = [] ( sc::stack_builder &&b, sc::value, unsigned width ) {
+        return std::move( b )
+              | sc::action::load( sc::i32(), "acc" )
+              | sc::action::add{ {}, sc::i32( width ) }
+              | sc::action::store{ {}, {}, "acc" };
+    };
+
+    auto bld = sc::stack_builder()
+          | sc::action::module{ sc::empty_module() }
+          | sc::action::create_function{ "steps", sc::i32(), { sc::i32(), sc::i32() } }
+          | sc::action::create_block{ "entry" };
+
+    auto fn = bld.functions.back();
+    auto loop = sc::action::loop( fn->getArg( 1 ), 7, body, 2, 2 );
+    loop.start = fn->getArg( 0 );
+
+    std::move( bld )
+          | sc::action::alloc( sc::i32(), "acc" )
+          | sc::action::store{ sc::i32( 0 ), {}, "acc" }
+          | std::move( loop )
+          | sc::action::load( sc::i32(), "acc" )
+          | sc::action::ret{};
+
+    std::unique_ptr< llvm::Module > m( fn->getParent() );
+
+    sc::jit engine;
+    engine.add( *m );
+    auto steps = engine.lookup< uint32_t( uint32_t, uint32_t ) >( "steps" );
+
+    auto expected = [] ( uint64_t start, uint64_t count ) {
+        uint32_t n = 0;
+        for ( auto iv = start; iv < count; iv += 7 )
+            ++n;
+        return n;
+    };
+
+    REQUIRE( steps( 0, 28 ) == expected( 0, 28 ) );
+    REQUIRE( steps( 0, 30 ) == expected( 0, 30 ) );
+    REQUIRE( steps( 3, 100 ) == expected( 3, 100 ) );
+    REQUIRE( steps( 10, 5 ) == 0 );
+    REQUIRE( steps( 0xffffff00, 5 ) == 0 );
+    REQUIRE( steps( 0xfffffff0, 0xffffffff ) == expected( 0xfffffff0, 0xffffffff ) );
+}
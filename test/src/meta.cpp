@@ -1,6 +1,14 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <sc/init.hpp>
 #include <sc/meta.hpp>
+#include <sc/types.hpp>
+
+#include <llvm/IR/GlobalVariable.h>
+
+#include <utils.hpp>
+
+#include <cstring>
 
 TEST_CASE( "meta" )
 {
@@ -14,4 +22,173 @@ TEST_CASE( "meta" )
         auto *n = sc::meta::node( "info" );
         REQUIRE( sc::meta::get_string( n ) );
     }
+
+    SECTION( "uniqued" )
+    {
+        std::unique_ptr< llvm::Module > m( sc::empty_module() );
+
+        auto global = [ & ] {
+            return new llvm::GlobalVariable( *m, sc::i32(), false,
+                llvm::GlobalValue::ExternalLinkage, nullptr );
+        };
+
+        auto a = global(), b = global(), c = global();
+        sc::meta::set( a, "sc.meta.test", "value", sc::meta::mode::uniqued );
+        sc::meta::set( b, "sc.meta.test", "value", sc::meta::mode::uniqued );
+        sc::meta::set( c, "sc.meta.test", "value" );
+
+        REQUIRE( a->getMetadata( "sc.meta.test" ) == b->getMetadata( "sc.meta.test" ) );
+        REQUIRE( a->getMetadata( "sc.meta.test" ) != c->getMetadata( "sc.meta.test" ) );
+        REQUIRE( sc::meta::get( b, "sc.meta.test" ) == "value" );
+    }
+
+    SECTION( "view" )
+    {
+        auto *n = sc::meta::node( "info" );
+        auto str = sc::meta::get_string( n );
+        REQUIRE( str == "info" );
+        REQUIRE( str->data() == llvm::cast< llvm::MDString >( n->getOperand( 0 ) )->getString().data() );
+    }
+}
+
+TEST_CASE( "meta lookup", "[.benchmark]" )
+{
+    sc::context_t ctx;
+    sc::init( ctx );
+
+    std::unique_ptr< llvm::Module > m( sc::empty_module() );
+
+    std::vector< llvm::GlobalVariable * > globals;
+    for ( int i = 0; i < 10000; ++i ) {
+        auto g = new llvm::GlobalVariable( *m, sc::i32(), false,
+            llvm::GlobalValue::ExternalLinkage, nullptr );
+        sc::meta::set( g, "sc.meta.test", "payload", sc::meta::mode::uniqued );
+        globals.push_back( g );
+    }
+
+    BENCHMARK( "get" )
+    {
+        std::size_t size = 0;
+        for ( auto g : globals )
+            size += sc::meta::get( g, "sc.meta.test" )->size();
+        return size;
+    };
+}
+
+TEST_CASE( "typed meta" )
+{
+    sc::context_t ctx;
+    sc::init( ctx );
+
+    std::unique_ptr< llvm::Module > m( sc::empty_module() );
+    auto g = new llvm::GlobalVariable( *m, sc::i32(), false,
+        llvm::GlobalValue::ExternalLinkage, nullptr );
+
+    SECTION( "integer" )
+    {
+        sc::meta::set( g, "sc.meta.int", -42 );
+        sc::meta::set( g, "sc.meta.wide", uint64_t( 1 ) << 40 );
+        sc::meta::set( g, "sc.meta.flag", true );
+
+        REQUIRE( sc::meta::get< int >( g, "sc.meta.int" ) == -42 );
+        REQUIRE( sc::meta::get< uint64_t >( g, "sc.meta.wide" ) == uint64_t( 1 ) << 40 );
+        REQUIRE( sc::meta::get< bool >( g, "sc.meta.flag" ) == true );
+
+        // width mismatch and string payloads are not decoded
+        REQUIRE( !sc::meta::get< short >( g, "sc.meta.int" ) );
+        REQUIRE( !sc::meta::get( g, "sc.meta.int" ) );
+    }
+
+    SECTION( "enum" )
+    {
+        enum class color : uint8_t { red, green, blue };
+        sc::meta::set( g, "sc.meta.color", color::blue, sc::meta::mode::uniqued );
+        REQUIRE( sc::meta::get< color >( g, "sc.meta.color" ) == color::blue );
+    }
+
+    SECTION( "record" )
+    {
+        struct point { int x; float y; };
+        sc::meta::set( g, "sc.meta.point", point{ 3, 0.5f } );
+
+        auto p = sc::meta::get< point >( g, "sc.meta.point" );
+        REQUIRE( p );
+        REQUIRE( p->x == 3 );
+        REQUIRE( p->y == 0.5f );
+    }
+
+    SECTION( "padded record" )
+    {
+        struct padded { char c; int i; };
+
+        // same fields over different garbage in the padding
+        padded a, b;
+        std::memset( static_cast< void * >( &a ), 0xaa, sizeof( a ) );
+        std::memset( static_cast< void * >( &b ), 0x55, sizeof( b ) );
+        a.c = b.c = 'x';
+        a.i = b.i = 7;
+
+        auto h = new llvm::GlobalVariable( *m, sc::i32(), false,
+            llvm::GlobalValue::ExternalLinkage, nullptr );
+        sc::meta::set( g, "sc.meta.padded", a, sc::meta::mode::uniqued );
+        sc::meta::set( h, "sc.meta.padded", b, sc::meta::mode::uniqued );
+        REQUIRE( sc::meta::get_node( g, "sc.meta.padded" ) == sc::meta::get_node( h, "sc.meta.padded" ) );
+    }
+
+    SECTION( "argument" )
+    {
+        auto fty = llvm::FunctionType::get( sc::void_t(), { sc::i32(), sc::i32() }, false );
+        auto fn = llvm::Function::Create( fty, llvm::GlobalValue::ExternalLinkage, "fn", m.get() );
+
+        sc::meta::set( fn->getArg( 1 ), sc::meta::tag::arguments, 7u );
+        REQUIRE( sc::meta::get< unsigned >( fn->getArg( 1 ), sc::meta::tag::arguments ) == 7u );
+        REQUIRE( !sc::meta::get< unsigned >( fn->getArg( 0 ), sc::meta::tag::arguments ) );
+    }
+}
+
+TEST_CASE( "argument meta" )
+{
+    sc::context_t ctx;
+    sc::init( ctx );
+
+    std::unique_ptr< llvm::Module > m( sc::empty_module() );
+
+    auto fty = llvm::FunctionType::get( sc::void_t(), { sc::i32(), sc::i32(), sc::i32() }, false );
+    auto function = [ & ] {
+        return llvm::Function::Create( fty, llvm::GlobalValue::ExternalLinkage, "fn", m.get() );
+    };
+
+    SECTION( "set all" )
+    {
+        auto fn = function();
+        std::vector< sc::meta::meta_str > strs = { "a", "b" };
+        sc::meta::argument::set_all( fn, strs );
+
+        auto tuple = fn->getMetadata( sc::meta::tag::arguments );
+        REQUIRE( sc::meta::argument::get( fn->getArg( 0 ) ) == "a" );
+        REQUIRE( sc::meta::argument::get( fn->getArg( 1 ) ) == "b" );
+        REQUIRE( sc::meta::argument::get( fn->getArg( 2 ) ) == sc::meta::tag::none );
+
+        strs = { "c" };
+        sc::meta::argument::set_all( fn, strs );
+        REQUIRE( fn->getMetadata( sc::meta::tag::arguments ) == tuple );
+        REQUIRE( sc::meta::argument::get( fn->getArg( 0 ) ) == "c" );
+        REQUIRE( sc::meta::argument::get( fn->getArg( 1 ) ) == "b" );
+    }
+
+    SECTION( "batch" )
+    {
+        auto f = function(), g = function();
+
+        sc::meta::argument::batch batch;
+        batch.set( f->getArg( 2 ), "x" );
+        batch.set( g->getArg( 0 ), "y" );
+        batch.set( f->getArg( 0 ), "y" );
+        REQUIRE( !f->getMetadata( sc::meta::tag::arguments ) );
+
+        batch.commit();
+        REQUIRE( sc::meta::argument::get( f->getArg( 0 ) ) == "y" );
+        REQUIRE( sc::meta::argument::get( f->getArg( 2 ) ) == "x" );
+        REQUIRE( sc::meta::argument::get( g->getArg( 0 ) ) == "y" );
+    }
 }
@@ -0,0 +1,77 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sc/init.hpp>
+#include <sc/meta_index.hpp>
+#include <sc/types.hpp>
+
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+
+#include <utils.hpp>
+
+TEST_CASE( "meta index" )
+{
+    sc::context_t ctx;
+    sc::init( ctx );
+
+    std::unique_ptr< llvm::Module > m( sc::empty_module() );
+
+    auto global = [ & ] {
+        return new llvm::GlobalVariable( *m, sc::i32(), false,
+            llvm::GlobalValue::ExternalLinkage, nullptr );
+    };
+
+    auto a = global(), b = global(), c = global();
+    sc::meta::set( a, "sc.meta.kind", "x" );
+    sc::meta::set( b, "sc.meta.kind", "y" );
+
+    auto fty = llvm::FunctionType::get( sc::void_t(), { sc::i32(), sc::i32() }, false );
+    auto fn = llvm::Function::Create( fty, llvm::GlobalValue::ExternalLinkage, "fn", m.get() );
+    sc::meta::argument::set( fn->getArg( 1 ), "arg" );
+
+    sc::meta::index idx( *m );
+
+    SECTION( "rebuild" )
+    {
+        REQUIRE( idx.values( "sc.meta.kind" ).size() == 2 );
+        REQUIRE( idx.values( "sc.meta.kind", "x" ) == std::vector< llvm::Value * >{ a } );
+        REQUIRE( idx.values( sc::meta::tag::arguments ) == std::vector< llvm::Value * >{ fn->getArg( 1 ) } );
+        REQUIRE( idx.values( "sc.meta.missing" ).empty() );
+    }
+
+    SECTION( "update" )
+    {
+        REQUIRE( idx.values( "sc.meta.kind" ).size() == 2 );
+
+        sc::meta::set( c, "sc.meta.kind", "x" );
+        sc::meta::set( a, "sc.meta.kind", "y" );
+        sc::meta::set( c, "sc.meta.count", 3 );
+
+        REQUIRE( idx.values( "sc.meta.kind" ).size() == 3 );
+        REQUIRE( idx.values( "sc.meta.kind", "x" ) == std::vector< llvm::Value * >{ c } );
+        REQUIRE( idx.values( "sc.meta.kind", "y" ).size() == 2 );
+        REQUIRE( idx.values( "sc.meta.count", 3 ) == std::vector< llvm::Value * >{ c } );
+    }
+
+    SECTION( "erase" )
+    {
+        REQUIRE( idx.values( "sc.meta.kind" ).size() == 2 );
+        b->eraseFromParent();
+        REQUIRE( idx.values( "sc.meta.kind" ) == std::vector< llvm::Value * >{ a } );
+    }
+
+    SECTION( "detached" )
+    {
+        REQUIRE( idx.values( "sc.meta.kind" ).size() == 2 );
+
+        auto add = llvm::BinaryOperator::CreateAdd( fn->getArg( 0 ), fn->getArg( 1 ) );
+        sc::meta::set( add, "sc.meta.kind", "x" );
+        REQUIRE( idx.values( "sc.meta.kind" ).size() == 2 );
+
+        auto entry = llvm::BasicBlock::Create( m->getContext(), "entry", fn );
+        entry->getInstList().push_back( add );
+        llvm::ReturnInst::Create( m->getContext(), entry );
+
+        idx.invalidate();
+        REQUIRE( idx.values( "sc.meta.kind", "x" ).size() == 2 );
+    }
+}
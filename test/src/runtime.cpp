@@ -0,0 +1,44 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sc/builder.hpp>
+#include <sc/init.hpp>
+#include <sc/runtime.hpp>
+
+#include <utils.hpp>
+
+TEST_CASE( "runtime" )
+{
+    sc::context_t ctx;
+    sc::init( ctx );
+
+    auto bld = sc::stack_builder()
+          | sc::action::module{ sc::empty_module() }
+          | sc::action::create_function{ "dummy", sc::void_t(), { sc::i8p(), sc::i32() } }
+          | sc::action::create_block{ "entry" };
+
+    auto fn = bld.functions.back();
+    sc::runtime rt( fn->getParent() );
+
+    auto &hook = rt.get( "__hook", sc::void_t(), { sc::i8p(), sc::i64() } );
+
+    SECTION( "declaration" )
+    {
+        REQUIRE( &rt.get( "__hook", sc::void_t(), { sc::i8p(), sc::i64() } ) == &hook );
+        REQUIRE( rt.size() == 1 );
+        REQUIRE( fn->getParent()->getFunction( "__hook" ) );
+    }
+
+    SECTION( "coercion" )
+    {
+        for ( int i = 0; i < 2; ++i ) {
+            bld = std::move( bld )
+                | sc::action::runtime_call{ hook, { fn->getArg( 0 ), fn->getArg( 1 ) } };
+        }
+
+        auto call = llvm::cast< llvm::CallInst >( bld.back() );
+        REQUIRE( call->getArgOperand( 0 ) == fn->getArg( 0 ) );
+
+        auto ext = llvm::cast< llvm::CastInst >( call->getArgOperand( 1 ) );
+        REQUIRE( ext->getOpcode() == llvm::Instruction::ZExt );
+        REQUIRE( ext->getOperand( 0 ) == fn->getArg( 1 ) );
+    }
+}
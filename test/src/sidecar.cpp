@@ -0,0 +1,133 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sc/init.hpp>
+#include <sc/sidecar.hpp>
+
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/ValueSymbolTable.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <cstring>
+#include <stdexcept>
+
+static const char *source = R"(
+@x = global i32 0
+@.str = private unnamed_addr constant [11 x i8] c"sc.test.ns\00", section "llvm.metadata"
+@llvm.global.annotations = appending global [1 x { i8*, i8*, i8*, i32, i8* }] [
+    { i8*, i8*, i8*, i32, i8* } { i8* bitcast (i32* @x to i8*),
+      i8* getelementptr inbounds ([11 x i8], [11 x i8]* @.str, i32 0, i32 0), i8* null, i32 0, i8* null } ],
+    section "llvm.metadata"
+
+define i32 @fn(i32 %a, i32 %b) {
+  %sum = add i32 %a, %b
+  %prod = mul i32 %sum, %b
+  ret i32 %prod
+}
+)";
+
+TEST_CASE( "sidecar" )
+{
+    sc::context_t ctx;
+    sc::init( ctx );
+
+    auto parse = [ & ] {
+        llvm::SMDiagnostic err;
+        auto m = llvm::parseAssemblyString( source, err, ctx );
+        REQUIRE( m );
+        return m;
+    };
+
+    auto first = parse();
+    auto fn = first->getFunction( "fn" );
+    auto mul = fn->getValueSymbolTable()->lookup( "prod" );
+
+    sc::meta::set( first->getNamedGlobal( "x" ), "sc.meta.kind", "global" );
+    sc::meta::set( fn, "sc.meta.kind", "function" );
+    sc::meta::set( mul, "sc.meta.kind", "mul" );
+    sc::meta::set( mul, "sc.meta.cost", 7 );
+    sc::meta::argument::set( fn->getArg( 1 ), "b" );
+
+    llvm::SmallString< 64 > path;
+    REQUIRE( !llvm::sys::fs::createTemporaryFile( "sc", "meta", path ) );
+    sc::meta::sidecar::write( *first, path.str().str() );
+
+    // fresh module without any sc metadata
+    auto second = parse();
+    auto store = sc::meta::sidecar::load( path.str().str() );
+    llvm::sys::fs::remove( path );
+
+    auto sfn = second->getFunction( "fn" );
+    auto sadd = sfn->getValueSymbolTable()->lookup( "sum" );
+    auto smul = sfn->getValueSymbolTable()->lookup( "prod" );
+
+    REQUIRE( store.size() == 6 );
+    REQUIRE( store.get( second->getNamedGlobal( "x" ), "sc.meta.kind" ) == "global" );
+    REQUIRE( store.get( sfn, "sc.meta.kind" ) == "function" );
+    REQUIRE( store.get( smul, "sc.meta.kind" ) == "mul" );
+    REQUIRE( store.get< int >( smul, "sc.meta.cost" ) == 7 );
+    REQUIRE( !store.get( sadd, "sc.meta.kind" ) );
+    REQUIRE( store.get( sfn->getArg( 1 ), sc::meta::tag::arguments ) == "b" );
+    REQUIRE( !store.get( sfn->getArg( 0 ), sc::meta::tag::arguments ) );
+
+    auto annos = store.annotations( second->getNamedGlobal( "x" ) );
+    REQUIRE( annos.size() == 1 );
+    REQUIRE( annos.front() == sc::annotation( "sc", "test", "ns" ) );
+
+    SECTION( "write error" )
+    {
+        // opens fine, every write fails with ENOSPC
+        if ( llvm::sys::fs::exists( "/dev/full" ) )
+            REQUIRE_THROWS_AS( sc::meta::sidecar::write( *first, "/dev/full" ), std::runtime_error );
+    }
+
+    SECTION( "new instructions" )
+    {
+        auto ret = sfn->getEntryBlock().getTerminator();
+        auto late = llvm::BinaryOperator::CreateAdd( sadd, sadd, "late", ret );
+        REQUIRE( !store.get( late, "sc.meta.kind" ) );
+        REQUIRE( store.get( smul, "sc.meta.kind" ) == "mul" );
+
+        auto detached = llvm::BinaryOperator::CreateAdd( sadd, sadd );
+        REQUIRE( !store.get( detached, "sc.meta.kind" ) );
+        detached->deleteValue();
+    }
+}
+
+TEST_CASE( "sidecar corrupted" )
+{
+    sc::context_t ctx;
+    sc::init( ctx );
+
+    llvm::SMDiagnostic err;
+    auto m = llvm::parseAssemblyString( source, err, ctx );
+    REQUIRE( m );
+    sc::meta::set( m->getNamedGlobal( "x" ), "sc.meta.kind", "global" );
+
+    llvm::SmallString< 64 > path;
+    REQUIRE( !llvm::sys::fs::createTemporaryFile( "sc", "meta", path ) );
+    sc::meta::sidecar::write( *m, path.str().str() );
+
+    auto buffer = llvm::MemoryBuffer::getFile( path );
+    REQUIRE( buffer );
+    std::string bytes = buffer.get()->getBuffer().str();
+
+    auto corrupt = [ & ] ( std::size_t offset, auto value ) {
+        auto copy = bytes;
+        std::memcpy( copy.data() + offset, &value, sizeof( value ) );
+        std::error_code ec;
+        llvm::raw_fd_ostream os( path, ec );
+        REQUIRE( !ec );
+        os << copy;
+        os.close();
+        REQUIRE_THROWS_AS( sc::meta::sidecar::load( path.str().str() ), std::runtime_error );
+    };
+
+    // header is magic followed by the entry count and the string table size
+    SECTION( "entry count overflow" ) { corrupt( 8, uint64_t( 1 ) << 59 ); }
+    SECTION( "string offset" ) { corrupt( 24, uint32_t{ 0xffffffff } ); }
+    SECTION( "string size" ) { corrupt( 28, uint32_t{ 0xfffffff0 } ); }
+
+    llvm::sys::fs::remove( path );
+}
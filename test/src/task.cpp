@@ -0,0 +1,139 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sc/scheduler.hpp>
+#include <sc/task.hpp>
+
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/SourceMgr.h>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    constexpr auto functions_source = R"(
+        define i32 @one(i32 %a) {
+          %b = add i32 %a, 1
+          ret i32 %b
+        }
+
+        define i32 @two(i32 %a) {
+          %b = add i32 %a, 1
+          %c = mul i32 %b, 2
+          ret i32 %c
+        }
+
+        define void @three() {
+          br label %next
+        next:
+          ret void
+        }
+    )";
+
+    sc::task< int > value( int v ) { co_return v; }
+
+    sc::task< int > sum( int a, int b ) { co_return co_await value( a ) + co_await value( b ); }
+
+} // anonymous namespace
+
+TEST_CASE( "task" )
+{
+    SECTION( "inline" )
+    {
+        REQUIRE( sc::sync_wait( sum( 20, 22 ) ) == 42 );
+    }
+
+    SECTION( "exception" )
+    {
+        auto fail = []() -> sc::task<> {
+            throw std::runtime_error( "failure" );
+            co_return;
+        };
+
+        REQUIRE_THROWS_AS( sc::sync_wait( fail() ), std::runtime_error );
+    }
+
+    SECTION( "empty when all" )
+    {
+        auto results = sc::sync_wait( sc::when_all( std::vector< sc::task< int > >{} ) );
+        REQUIRE( results.empty() );
+    }
+}
+
+TEST_CASE( "scheduler" )
+{
+    sc::scheduler pool( 4 );
+    REQUIRE( pool.size() == 4 );
+
+    SECTION( "module fan out" )
+    {
+        llvm::LLVMContext ctx;
+        llvm::SMDiagnostic err;
+        auto m = llvm::parseAssemblyString( functions_source, err, ctx );
+        REQUIRE( m );
+
+        auto count = [&] ( llvm::Function &fn ) -> sc::task< std::size_t > {
+            co_await pool.schedule();
+            co_return fn.getInstructionCount();
+        };
+
+        std::vector< sc::task< std::size_t > > tasks;
+        for ( auto &fn : *m ) {
+            tasks.push_back( count( fn ) );
+        }
+
+        auto counts = sc::sync_wait( sc::when_all( std::move( tasks ) ) );
+        REQUIRE( counts == std::vector< std::size_t >{ 2, 3, 2 } );
+    }
+
+    SECTION( "nested fan out" )
+    {
+        std::atomic< int > visited = 0;
+
+        auto leaf = [&] ( int v ) -> sc::task< int > {
+            co_await pool.schedule();
+            ++visited;
+            co_return v;
+        };
+
+        auto node = [&] ( int base ) -> sc::task< int > {
+            co_await pool.schedule();
+            std::vector< sc::task< int > > leaves;
+            for ( int i = 0; i < 64; ++i ) {
+                leaves.push_back( leaf( base + i ) );
+            }
+            auto values = co_await sc::when_all( std::move( leaves ) );
+            co_return std::accumulate( values.begin(), values.end(), 0 );
+        };
+
+        std::vector< sc::task< int > > nodes;
+        for ( int i = 0; i < 16; ++i ) {
+            nodes.push_back( node( i * 64 ) );
+        }
+
+        auto sums = sc::sync_wait( sc::when_all( std::move( nodes ) ) );
+        REQUIRE( visited == 16 * 64 );
+        REQUIRE( std::accumulate( sums.begin(), sums.end(), 0 ) == ( 16 * 64 ) * ( 16 * 64 - 1 ) / 2 );
+    }
+
+    SECTION( "void tasks" )
+    {
+        std::atomic< int > visited = 0;
+
+        auto touch = [&] () -> sc::task<> {
+            co_await pool.schedule();
+            ++visited;
+        };
+
+        std::vector< sc::task<> > tasks;
+        for ( int i = 0; i < 100; ++i ) {
+            tasks.push_back( touch() );
+        }
+
+        sc::sync_wait( sc::when_all( std::move( tasks ) ) );
+        REQUIRE( visited == 100 );
+    }
+}